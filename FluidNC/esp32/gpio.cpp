@@ -17,6 +17,21 @@ static gpio_dev_t* _gpio_dev = GPIO_HAL_GET_HW(GPIO_PORT_0);
 void IRAM_ATTR gpio_write(pinnum_t pin, bool value) {
     gpio_ll_set_level(_gpio_dev, (gpio_num_t)pin, value);
 }
+void IRAM_ATTR gpio_write_masks(const uint32_t* set, const uint32_t* clear) {
+    // Each store changes every selected pin of its bank at the same time
+    if (set[0]) {
+        _gpio_dev->out_w1ts = set[0];
+    }
+    if (clear[0]) {
+        _gpio_dev->out_w1tc = clear[0];
+    }
+    if (set[1]) {
+        _gpio_dev->out1_w1ts.val = set[1];
+    }
+    if (clear[1]) {
+        _gpio_dev->out1_w1tc.val = clear[1];
+    }
+}
 bool IRAM_ATTR gpio_read(pinnum_t pin) {
     return gpio_ll_get_level(_gpio_dev, (gpio_num_t)pin);
 }
@@ -8,6 +8,9 @@
 // GPIO interface
 
 void gpio_write(pinnum_t pin, bool value);
+// Sets and clears many outputs with one register store per bank.  Word 0 holds
+// GPIOs 0-31 and word 1 holds GPIOs 32 and up, one bit per GPIO.
+void gpio_write_masks(const uint32_t* set, const uint32_t* clear);
 bool gpio_read(pinnum_t pin);
 void gpio_mode(pinnum_t pin, bool input, bool output, bool pullup, bool pulldown, bool opendrain = false);
 void gpio_set_interrupt_type(pinnum_t pin, int mode);
@@ -7,12 +7,31 @@
 #include "Serial.h"                 // execute_realtime_command
 #include "Limits.h"
 
+#include <algorithm>
+#include <cstring>
+
 void Channel::flushRx() {
     _linelen   = 0;
     _lastWasCR = false;
     while (_queue.size()) {
         _queue.pop();
     }
+    _rxStart = _rxEnd = 0;
+    // Lines that were discarded are never acked, so the numbering starts over
+    // with the first line after the reset
+    _ackSeq = 1;
+}
+
+int Channel::startStreaming() {
+    // The line that turns streaming on has been taken out of the receive buffer
+    // already, so the space that is available now is the whole window
+    int window = rx_buffer_available();
+    if (window > 0) {
+        _streaming    = true;
+        _streamWindow = window;
+        _ackSeq       = 0;
+    }
+    return window;
 }
 
 bool Channel::lineComplete(char* line, char ch) {
@@ -68,13 +87,19 @@ bool Channel::lineComplete(char* line, char ch) {
 uint32_t Channel::setReportInterval(uint32_t ms) {
     uint32_t actual = ms;
     if (actual) {
-        actual = std::max(actual, uint32_t(50));
+        actual = std::max(actual, uint32_t(_compactReports ? 10 : 50));
     }
     _reportInterval = actual;
     _nextReportTime = int32_t(xTaskGetTickCount());
     _lastTool       = 255;  // Force GCodeState report
     return actual;
 }
+void Channel::setCompactReports(bool on) {
+    _compactReports = on;
+    // The shortest interval depends on the kind of report
+    setReportInterval(_reportInterval);
+}
+
 void Channel::autoReportGCodeState() {
     if (memcmp(&_lastModal, &gc_state.modal, sizeof(_lastModal)) || _lastTool != gc_state.tool ||
         _lastSpindleSpeed != gc_state.spindle_speed || _lastFeedRate != gc_state.feed_rate) {
@@ -101,7 +126,11 @@ void Channel::autoReport() {
             _lastState      = sys.state;
             _lastLimits     = limitState;
             _nextReportTime = xTaskGetTickCount() + _reportInterval;
-            report_realtime_status(*this);
+            if (_compactReports) {
+                report_compact_status(*this);
+            } else {
+                report_realtime_status(*this);
+            }
         }
         if (_reportNgc != CoordIndex::End) {
             report_ngc_coord(_reportNgc, *this);
@@ -111,8 +140,164 @@ void Channel::autoReport() {
     }
 }
 
+void Channel::addPlain(const char* s, size_t len) {
+    // Characters past the end of the line are dropped, as in lineComplete()
+    size_t n = std::min(len, size_t(Channel::maxLine - 1) - _linelen);
+    memcpy(_line + _linelen, s, n);
+    _linelen += n;
+    _lastWasCR = false;
+}
+
+// Returns the number of characters at the start of s, up to len, that are
+// neither realtime characters nor control characters.  Four characters are
+// checked at a time with the usual bit tricks for finding bytes in a word.
+static size_t plainRun(const char* s, size_t len) {
+    const uint32_t ones  = 0x01010101;
+    const uint32_t highs = 0x80808080;
+    auto           zero  = [=](uint32_t v) { return (v - ones) & ~v & highs; };
+
+    size_t n = 0;
+    for (; n + 4 <= len; n += 4) {
+        uint32_t word;
+        memcpy(&word, s + n, 4);
+        uint32_t special = ((word - ones * 0x20) & ~word) |  // Below space
+                           ((word + ones) | word) |          // DEL or above
+                           zero(word ^ (ones * '?')) | zero(word ^ (ones * '~')) | zero(word ^ (ones * '!'));
+        if (special & highs) {
+            break;
+        }
+    }
+    for (; n < len; n++) {
+        uint8_t c = s[n];
+        if (c < ' ' || c >= 0x7f || c == '?' || c == '~' || c == '!') {
+            break;
+        }
+    }
+    return n;
+}
+
+// Handles one character.  Returns true if it completes a line.
+bool Channel::pollChar(char* line, uint8_t ch) {
+    if (realtimeOkay(ch) && is_realtime_command(ch)) {
+        execute_realtime_command(static_cast<Cmd>(ch), *this);
+        return false;
+    }
+    if (!line) {
+        // If we are not able to handle a line we save the character
+        // until later
+        _queue.push(ch);
+        return false;
+    }
+    return lineComplete(line, ch);
+}
+
+// Works through _rx.  Returns true if a line is complete.
+bool Channel::scanRx(char* line) {
+    if (!line) {
+        // Only realtime characters are acted on now.  They are blanked so they
+        // are not acted on again, and the line characters stay where they are.
+        for (size_t i = _rxStart; i < _rxEnd; i++) {
+            i += plainRun(_rx + i, _rxEnd - i);
+            if (i == _rxEnd) {
+                break;
+            }
+            uint8_t ch = _rx[i];
+            if (ch && realtimeOkay(ch) && is_realtime_command(ch)) {
+                execute_realtime_command(static_cast<Cmd>(ch), *this);
+                _rx[i] = '\0';
+            }
+        }
+        return false;
+    }
+    while (_rxStart < _rxEnd) {
+        size_t n = plainRun(_rx + _rxStart, _rxEnd - _rxStart);
+        if (n) {
+            addPlain(_rx + _rxStart, n);
+            _rxStart += n;
+            continue;
+        }
+        uint8_t ch = _rx[_rxStart++];
+        if (ch == '\0') {
+            continue;  // A realtime character that was acted on already
+        }
+        if (pollChar(line, ch)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Channel::fillRx() {
+    if (_rxStart == _rxEnd) {
+        _rxStart = _rxEnd = 0;
+    } else if (_rxStart) {
+        memmove(_rx, _rx + _rxStart, _rxEnd - _rxStart);
+        _rxEnd -= _rxStart;
+        _rxStart = 0;
+    }
+    _rxEnd += readRx(_rx + _rxEnd, rxSize - _rxEnd);
+}
+
+int Channel::takeBuffered() {
+    while (_rxStart < _rxEnd) {
+        uint8_t ch = _rx[_rxStart++];
+        if (ch) {
+            return ch;
+        }
+    }
+    if (_queue.size()) {
+        uint8_t ch = _queue.front();
+        _queue.pop();
+        return ch;
+    }
+    return -1;
+}
+
+int Channel::peekBuffered() {
+    while (_rxStart < _rxEnd) {
+        if (_rx[_rxStart]) {
+            return uint8_t(_rx[_rxStart]);
+        }
+        ++_rxStart;
+    }
+    return _queue.size() ? _queue.front() : -1;
+}
+
+size_t Channel::buffered() {
+    return _rxEnd - _rxStart + _queue.size();
+}
+
 Channel* Channel::pollLine(char* line) {
     handle();
+    if (_rx) {
+        // Received characters are in _rx, then in _queue, then in the device.
+        if (scanRx(line)) {
+            return this;
+        }
+        while (line && _queue.size()) {
+            uint8_t ch = _queue.front();
+            _queue.pop();
+            if (pollChar(line, ch)) {
+                return this;
+            }
+        }
+        if (_queue.empty()) {
+            fillRx();
+            if (scanRx(line)) {
+                return this;
+            }
+        }
+        if (!line && (_queue.size() || _rxEnd == rxSize)) {
+            // _rx is full of lines that are not wanted yet.  Read on one character
+            // at a time, so realtime characters are still acted on right away.
+            char ch;
+            while (readRx(&ch, 1) == 1) {
+                pollChar(line, ch);
+            }
+        }
+        autoReport();
+        return nullptr;
+    }
     while (1) {
         int ch;
         if (line && _queue.size()) {
@@ -127,17 +312,7 @@ Channel* Channel::pollLine(char* line) {
         if (ch < 0) {
             break;
         }
-        if (realtimeOkay(ch) && is_realtime_command(ch)) {
-            execute_realtime_command(static_cast<Cmd>(ch), *this);
-            continue;
-        }
-        if (!line) {
-            // If we are not able to handle a line we save the character
-            // until later
-            _queue.push(uint8_t(ch));
-            continue;
-        }
-        if (line && lineComplete(line, ch)) {
+        if (pollChar(line, ch)) {
             return this;
         }
     }
@@ -146,6 +321,16 @@ Channel* Channel::pollLine(char* line) {
 }
 
 void Channel::ack(Error status) {
+    if (_streaming) {
+        uint32_t seq = _ackSeq++;
+        if (status == Error::Ok) {
+            log_to(*this, "ok:", seq);
+            return;
+        }
+        LogStream msg(*this, "error:");
+        msg << static_cast<int>(status) << ":" << seq;
+        return;
+    }
     if (status == Error::Ok) {
         log_to(*this, "ok");
         return;
@@ -13,12 +13,19 @@
 // overrunning input buffers.  The default implementation of ack() sends
 // "ok" and "error:" messages via the standard Grbl serial protocol, but it
 // could be implemented in other ways for different channel protocols.
+//
+// A sender can also turn on streaming mode with $Stream=On.  The channel then
+// advertises its receive window in bytes, and each ack carries the sequence number
+// of the line that it answers, as "ok:<seq>" or "error:<code>:<seq>".  The sender
+// can keep sending as long as the unacked lines, newlines included, fit in the
+// window, so the planner stays full without a round trip per line.
 
 #pragma once
 
 #include "Error.h"  // Error
 #include "GCode.h"  // gc_modal_t
 #include "Types.h"  // State
+#include "WebUI/Authentication.h"
 #include <Stream.h>
 #include <freertos/FreeRTOS.h>  // TickType_T
 #include <queue>
@@ -36,6 +43,31 @@ protected:
 
     std::queue<uint8_t> _queue;
 
+    // Bulk input.  A channel whose device can deliver many bytes per call calls
+    // enableBulkInput() and overrides readRx().  pollLine() then takes input into
+    // _rx a block at a time and scans it in place, instead of calling read() for
+    // every character.  Realtime characters that are acted on while no line is
+    // wanted are blanked to '\0' and the rest is left for later.
+    static const size_t rxSize = 256;
+
+    char*  _rx      = nullptr;
+    size_t _rxStart = 0;  // The next character to be scanned
+    size_t _rxEnd   = 0;  // The end of the received characters
+
+    void enableBulkInput() { _rx = new char[rxSize]; }
+
+    // Reads up to len bytes from the device without waiting, returning the count
+    virtual size_t readRx(char* buffer, size_t len) { return 0; }
+
+    // Adds characters that are neither realtime nor line control to the line
+    virtual void addPlain(const char* s, size_t len);
+
+    // Characters that have been received from the device but not taken into a
+    // line, in order, for read() and the like in channels with bulk input
+    int    takeBuffered();
+    int    peekBuffered();
+    size_t buffered();
+
     uint32_t _reportInterval = 0;
     int32_t  _nextReportTime = 0;
 
@@ -49,15 +81,24 @@ protected:
     bool       _reportWco = true;
     CoordIndex _reportNgc = CoordIndex::End;
 
+    bool _compactReports = false;
+
+    bool     _streaming    = false;
+    int      _streamWindow = 0;  // The window that startStreaming() returned
+    uint32_t _ackSeq       = 0;  // The sequence number of the next line to be acked
+
 public:
     Channel(const char* name, bool addCR = false) : _name(name), _linelen(0), _addCR(addCR) {}
-    virtual ~Channel() = default;
+    virtual ~Channel() { delete[] _rx; }
 
     virtual void     handle() {};
     virtual Channel* pollLine(char* line);
     virtual void     ack(Error status);
     const char*      name() { return _name; }
 
+    // The authentication level at which lines from this channel are executed
+    virtual WebUI::AuthenticationLevel authLevel() { return WebUI::AuthenticationLevel::LEVEL_GUEST; }
+
     // rx_buffer_available() is the number of bytes that can be sent without overflowing
     // a reception buffer, even if the system is busy.  Channels that can handle external
     // input via an interrupt or other background mechanism should override it to return
@@ -79,6 +120,13 @@ public:
     // end is seen.
     virtual bool lineComplete(char* line, char c);
 
+private:
+    bool pollChar(char* line, uint8_t ch);
+    bool scanRx(char* line);
+    void fillRx();
+
+public:
+
     virtual size_t timedReadBytes(char* buffer, size_t length, TickType_t timeout) {
         setTimeout(timeout);
         return readBytes(buffer, length);
@@ -94,6 +142,14 @@ public:
         return retval;
     }
 
+    // startStreaming() turns on sequence-numbered acks, beginning with the line that is
+    // being executed, which is acked as 0.  It returns the window in bytes, or 0 if the
+    // channel has no receive buffer to stream into.
+    int  startStreaming();
+    void stopStreaming() { _streaming = false; }
+    bool isStreaming() { return _streaming; }
+    int  streamWindow() { return _streamWindow; }
+
     void notifyWco() { _reportWco = true; }
     void notifyNgc(CoordIndex coord) { _reportNgc = coord; }
 
@@ -101,6 +157,11 @@ public:
     int read() override { return -1; }
     int available() override { return 0; }
 
+    // Compact reports replace the <...> auto reports with fixed-width frames,
+    // which are cheap enough to send every 10 ms.  See report_compact_status().
+    void setCompactReports(bool on);
+    bool compactReports() { return _compactReports; }
+
     uint32_t setReportInterval(uint32_t ms);
     uint32_t getReportInterval() { return _reportInterval; }
     void     autoReport();
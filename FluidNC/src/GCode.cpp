@@ -6,6 +6,7 @@
 // RS274/NGC parser.
 
 #include "GCode.h"
+#include "GCodeTokenizer.h"
 #include "Settings.h"
 #include "Config.h"
 #include "Report.h"
@@ -31,10 +32,25 @@ CoordIndex& operator++(CoordIndex& i) {
 // value when converting a float (7.2 digit precision)s to an integer.
 static const int32_t MaxLineNumber = 10000000;
 
+// Words of the line being executed
+static gc_words_t gc_words;
+
+// Pixels for the next block, from gc_execute_raster()
+static const uint8_t* gc_raster        = nullptr;
+static uint16_t       gc_raster_pixels = 0;
+
 // Declare gc extern struct
 parser_state_t gc_state;
 parser_block_t gc_block;
 
+uint32_t gc_fast_path_lines = 0;
+uint32_t gc_full_path_lines = 0;
+
+// The modal state after the last line that executed without error, if it
+// leaves modal G1 moves eligible for gc_execute_fast_linear()
+static gc_modal_t gc_fast_modal;
+static bool       gc_fast_valid = false;
+
 #define FAIL(status) return (status);
 
 void gc_init() {
@@ -45,6 +61,14 @@ void gc_init() {
     gc_state.modal.coord_select = CoordIndex::G54;
     gc_state.modal.override     = config->_start->_deactivateParking ? Override::Disabled : Override::ParkingMotion;
     coords[gc_state.modal.coord_select]->get(gc_state.coord_system);
+    gc_fast_valid = false;
+}
+
+// Executes a G1 line whose move carries n_pixels raster power values. Called by $Raster.
+Error gc_execute_raster(char* line, const uint8_t* pixels, uint16_t n_pixels) {
+    gc_raster        = pixels;
+    gc_raster_pixels = n_pixels;
+    return gc_execute_line(line);
 }
 
 // Sets g-code parser position in mm. Input in steps. Called by the system abort and hard
@@ -53,97 +77,164 @@ void gc_sync_position() {
     motor_steps_to_mpos(gc_state.position, get_motor_steps());
 }
 
-static void gcode_comment_msg(char* comment) {
-    char         msg[80];
-    const size_t offset = 4;  // ignore "MSG_" part of comment
-    size_t       index  = offset;
-    if (strstr(comment, "MSG")) {
-        while (index < strlen(comment)) {
-            msg[index - offset] = comment[index];
-            index++;
-        }
-        msg[index - offset] = 0;  // null terminate
-        log_info("GCode Comment..." << msg);
+static void gc_ngc_changed(CoordIndex coord) {
+    allChannels.notifyNgc(coord);
+}
+
+static void gc_wco_changed() {
+    if (FORCE_BUFFER_SYNC_DURING_WCO_CHANGE) {
+        protocol_buffer_synchronize();
     }
+    allChannels.notifyWco();
 }
 
-// Edit GCode line in-place, removing whitespace and comments and
-// converting to uppercase
-void collapseGCode(char* line) {
-    // parenPtr, if non-NULL, is the address of the character after (
-    char* parenPtr = NULL;
-    // outPtr is the address where newly-processed characters will be placed.
-    // outPtr is alway less than or equal to inPtr.
-    char* outPtr = line;
-    char  c;
-    for (char* inPtr = line; (c = *inPtr) != '\0'; inPtr++) {
-        if (isspace(c)) {
-            continue;
-        }
-        switch (c) {
-            case ')':
-                if (parenPtr) {
-                    // Terminate comment by replacing ) with NUL
-                    *inPtr = '\0';
-                    gcode_comment_msg(parenPtr);
-                    parenPtr = NULL;
-                }
-                // Strip out ) that does not follow a (
+// Fast path for the lines that make up most of a 3D or raster job: a modal G1 move with
+// only axis words and optional N, F and S words.  When the modal state is the same as
+// after the previous line, which was checked in full, the modal group checks cannot fail
+// and the line reduces to computing the target and queueing it, the same way as below.
+// Returns false, having changed nothing, for any line that needs the full parser.
+static bool gc_execute_fast_linear() {
+    if (!gc_fast_valid || gc_words.error != Error::Ok || gc_words.jog ||
+        memcmp(&gc_state.modal, &gc_fast_modal, sizeof(gc_modal_t)) != 0) {
+        return false;
+    }
+    auto     n_axis             = config->_axes->_numberAxis;
+    float    target[MAX_N_AXIS] = {};
+    float    feed_rate          = gc_state.feed_rate;
+    float    spindle_speed      = gc_state.spindle_speed;
+    int32_t  line_number        = 0;
+    uint32_t axis_words         = 0;
+    uint32_t value_words        = 0;
+    for (size_t word = 0; word < gc_words.count; word++) {
+        auto&  w = gc_words.words[word];
+        size_t axis;
+        switch (w.letter) {
+            case 'X':
+                axis = X_AXIS;
                 break;
-            case '(':
-                // Start the comment at the character after (
-                parenPtr = inPtr + 1;
+            case 'Y':
+                axis = Y_AXIS;
                 break;
-            case ';':
-                // NOTE: ';' comment to EOL is a LinuxCNC definition. Not NIST.
-                // gcode_comment_msg(inPtr + 1);
-                *outPtr = '\0';
-                return;
-            case '%':
-                // TODO: Install '%' feature
-                // Program start-end percent sign NOT SUPPORTED.
-                // NOTE: This may be installed to distinguish between program running vs manual input,
-                // where, during a program, the system auto-cycle start will continue to execute
-                // everything until the next '%' sign. This will help fix resuming issues with certain
-                // functions that empty the planner buffer to execute its task on-time.
+            case 'Z':
+                axis = Z_AXIS;
                 break;
-            case '\r':
-                // In case one sneaks in
+            case 'A':
+                axis = A_AXIS;
                 break;
-            default:
-                if (!parenPtr) {
-                    *outPtr++ = toupper(c);  // make upper case
+            case 'B':
+                axis = B_AXIS;
+                break;
+            case 'C':
+                axis = C_AXIS;
+                break;
+            case 'F':
+                if (bitnum_is_true(value_words, GCodeWord::F) || w.value < 0.0) {
+                    return false;
+                }
+                set_bitnum(value_words, GCodeWord::F);
+                feed_rate = w.value;
+                if (gc_state.modal.units == Units::Inches) {
+                    feed_rate *= MM_PER_INCH;
                 }
+                continue;
+            case 'S':
+                if (bitnum_is_true(value_words, GCodeWord::S) || w.value < 0.0) {
+                    return false;
+                }
+                set_bitnum(value_words, GCodeWord::S);
+                spindle_speed = w.value;
+                continue;
+            case 'N':
+                if (bitnum_is_true(value_words, GCodeWord::N) || w.value < 0.0) {
+                    return false;
+                }
+                set_bitnum(value_words, GCodeWord::N);
+                line_number = int32_t(truncf(w.value));
+                if (line_number > MaxLineNumber) {
+                    return false;
+                }
+                continue;
+            default:
+                return false;
         }
+        if (axis >= n_axis || bitnum_is_true(axis_words, axis)) {
+            return false;
+        }
+        set_bitnum(axis_words, axis);
+        target[axis] = w.value;
     }
-    // On loop exit, *inPtr is '\0'
-    if (parenPtr) {
-        // Handle unterminated ( comments
-        gcode_comment_msg(parenPtr);
+    if (!axis_words || feed_rate == 0.0) {
+        return false;
     }
-    *outPtr = '\0';
-}
 
-static void gc_ngc_changed(CoordIndex coord) {
-    allChannels.notifyNgc(coord);
-}
+    // The line is valid.  From here on this follows STEP 3 and STEP 4 of gc_execute_line()
+    // for a G1 block with axis words.
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        if (bitnum_is_false(axis_words, idx)) {
+            target[idx] = gc_state.position[idx];
+            continue;
+        }
+        if (gc_state.modal.units == Units::Inches && (idx < A_AXIS || idx > C_AXIS)) {
+            target[idx] *= MM_PER_INCH;
+        }
+        if (gc_state.modal.distance == Distance::Absolute) {
+            target[idx] += gc_state.coord_system[idx] + gc_state.coord_offset[idx];
+            if (idx == TOOL_LENGTH_OFFSET_AXIS) {
+                target[idx] += gc_state.tool_length_offset;
+            }
+        } else {
+            target[idx] += gc_state.position[idx];
+        }
+    }
 
-static void gc_wco_changed() {
-    if (FORCE_BUFFER_SYNC_DURING_WCO_CHANGE) {
-        protocol_buffer_synchronize();
+    plan_line_data_t plan_data;
+    memset(&plan_data, 0, sizeof(plan_line_data_t));
+    gc_state.line_number  = line_number;
+    plan_data.line_number = line_number;
+    gc_state.feed_rate    = feed_rate;
+    plan_data.feed_rate   = feed_rate;
+    if (gc_state.spindle_speed != spindle_speed) {
+        // In laser mode, a G1 move with axis words carries the new power in the planner
+        if (gc_state.modal.spindle != SpindleState::Disable && !spindle->isRateAdjusted()) {
+            if (sys.state != State::CheckMode) {
+                protocol_buffer_synchronize();
+                spindle->setState(gc_state.modal.spindle, (uint32_t)spindle_speed);
+                report_ovr_counter = 0;  // Set to report change immediately
+            }
+        }
+        gc_state.spindle_speed = spindle_speed;
     }
-    allChannels.notifyWco();
+    plan_data.spindle_speed = gc_state.spindle_speed;
+    plan_data.spindle       = gc_state.modal.spindle;
+    plan_data.coolant       = gc_state.modal.coolant;
+    mc_linear(target, &plan_data, gc_state.position);
+    copyAxes(gc_state.position, target);
+    return true;
 }
 
 // Executes one line of NUL-terminated G-Code.
-// The line may contain whitespace and comments, which are first removed,
-// and lower case characters, which are converted to upper case.
+// The line may contain whitespace and comments, which are skipped,
+// and lower case characters, which are read as upper case.
 // In this function, all units and positions are converted and
 // exported to internal functions in terms of (mm, mm/min) and absolute machine
 // coordinates, respectively.
 Error gc_execute_line(char* line) {
-    // Step 0 - remove whitespace and comments and convert to upper case
-    collapseGCode(line);
+    // Pixels belong to this block only, not to blocks that it might execute in turn
+    const uint8_t* raster        = gc_raster;
+    uint16_t       raster_pixels = gc_raster_pixels;
+    gc_raster                    = nullptr;
+    gc_raster_pixels             = 0;
+
+    // Step 0 - split the line into words, skipping whitespace and comments
+    gc_tokenize(line, gc_words);
+
+    if (config->_gcodeFastPath && !raster_pixels && gc_execute_fast_linear()) {
+        gc_fast_path_lines++;
+        return Error::Ok;
+    }
+    gc_full_path_lines++;
+    // A line that fails leaves no modal state for the fast path to trust
+    gc_fast_valid = false;
 
     /* -------------------------------------------------------------------------------------
        STEP 1: Initialize parser block struct and copy current g-code state modes. The parser
@@ -178,7 +269,7 @@ Error gc_execute_line(char* line) {
     uint8_t pValue;                  // Integer value of P word
 
     // Determine if the line is a jogging motion or a normal g-code block.
-    if (line[0] == '$') {  // NOTE: `$J=` already parsed when passed to this function.
+    if (gc_words.jog) {  // NOTE: `$J=` already parsed when passed to this function.
         // Set G1 and G94 enforced modes to ensure accurate error checks.
         jogMotion                = true;
         gc_block.modal.motion    = Motion::Linear;
@@ -195,32 +286,21 @@ Error gc_execute_line(char* line) {
        words, and for negative values set for the value words F, N, P, T, and S. */
     ModalGroup mg_word_bit;  // Bit-value for assigning tracking variables
     uint32_t   bitmask = 0;
-    size_t     char_counter;
     char       letter;
     float      value;
     uint8_t    int_value = 0;
     uint16_t   mantissa  = 0;
-    char_counter         = jogMotion ? 3 : 0;  // Start parsing after `$J=` if jogging
-    while (line[char_counter] != 0) {          // Loop until no more g-code words in line.
-        // Import the next g-code word, expecting a letter followed by a value. Otherwise, error out.
-        letter = line[char_counter];
-        if ((letter < 'A') || (letter > 'Z')) {
-            FAIL(Error::ExpectedCommandLetter);  // [Expected word letter]
-        }
-        char_counter++;
-        if (!read_float(line, &char_counter, &value)) {
-            FAIL(Error::BadNumberFormat);  // [Expected word value]
-        }
-        // Convert values to smaller uint8 significand and mantissa values for parsing this word.
+    for (size_t word = 0; word < gc_words.count; word++) {  // Loop over the g-code words in the line.
+        letter    = gc_words.words[word].letter;
+        value     = gc_words.words[word].value;
+        int_value = gc_words.words[word].int_value;
         // NOTE: Mantissa is multiplied by 100 to catch non-integer command values. This is more
         // accurate than the NIST gcode requirement of x10 when used for commands, but not quite
         // accurate enough for value words that require integers to within 0.0001. This should be
         // a good enough compromise and catch most all non-integer errors. To make it compliant,
         // we would simply need to change the mantissa to int16, but this add compiled flash space.
         // Maybe update this later.
-        int_value = int8_t(truncf(value));
-        mantissa  = lroundf(100 * (value - int_value));  // Compute mantissa for Gxx.x commands.
-        // NOTE: Rounding must be used to catch small floating point errors.
+        mantissa = gc_words.words[word].mantissa;
         // Check if the g-code word is supported or errors due to modal group violations or has
         // been repeated in the g-code block. If ok, update the command or record its value.
         switch (letter) {
@@ -739,6 +819,10 @@ Error gc_execute_line(char* line) {
                 value_words |= bitmask;  // Flag to indicate parameter assigned.
         }
     }
+    // A letter without a value, or a value without a letter, ends the words
+    if (gc_words.error != Error::Ok) {
+        FAIL(gc_words.error);
+    }
     // Parsing complete!
     /* -------------------------------------------------------------------------------------
        STEP 3: Error-check all commands and values passed in this block. This step ensures all of
@@ -1322,6 +1406,15 @@ Error gc_execute_line(char* line) {
     if (value_words) {
         FAIL(Error::GcodeUnusedWords);  // [Unused words]
     }
+    // [Raster]: The pixels are spread along a G1 move, which has to stay one planner block.
+    if (raster_pixels) {
+        if (jogMotion || gc_block.modal.motion != Motion::Linear || axis_command != AxisCommand::MotionMode) {
+            FAIL(Error::GcodeUnsupportedCommand);
+        }
+        if (!config->_kinematics->motorSpaceIsCartesian() || raster_pixels > plan_raster_capacity()) {
+            FAIL(Error::GcodeUnsupportedCommand);
+        }
+    }
     /* -------------------------------------------------------------------------------------
        STEP 4: EXECUTE!!
        Assumes that all error-checking has been completed and no failure modes exist. We just
@@ -1598,7 +1691,11 @@ Error gc_execute_line(char* line) {
         if (axis_command == AxisCommand::MotionMode) {
             GCUpdatePos gc_update_pos = GCUpdatePos::Target;
             if (gc_state.modal.motion == Motion::Linear) {
-                mc_linear(gc_block.values.xyz, pl_data, gc_state.position);
+                if (raster_pixels) {
+                    mc_raster(gc_block.values.xyz, pl_data, gc_state.position, raster, raster_pixels);
+                } else {
+                    mc_linear(gc_block.values.xyz, pl_data, gc_state.position);
+                }
             } else if (gc_state.modal.motion == Motion::Seek) {
                 pl_data->motion.rapidMotion = 1;  // Set rapid motion flag.
                 mc_linear(gc_block.values.xyz, pl_data, gc_state.position);
@@ -1694,6 +1791,12 @@ Error gc_execute_line(char* line) {
     }
     gc_state.modal.program_flow = ProgramFlow::Running;  // Reset program flow.
 
+    // Later modal G1 lines can skip the checks above while this state lasts
+    if (gc_state.modal.motion == Motion::Linear && gc_state.modal.feed_rate == FeedRate::UnitsPerMin) {
+        memcpy(&gc_fast_modal, &gc_state.modal, sizeof(gc_modal_t));
+        gc_fast_valid = true;
+    }
+
     // TODO: % to denote start of program.
     return Error::Ok;
 }
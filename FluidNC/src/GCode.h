@@ -286,6 +286,10 @@ struct parser_state_t {
 
 extern parser_state_t gc_state;
 
+// Lines executed by the modal G1 fast path and by the full parser, see gcode_fast_path
+extern uint32_t gc_fast_path_lines;
+extern uint32_t gc_full_path_lines;
+
 struct parser_block_t {
     NonModal     non_modal_command;
     gc_modal_t   modal;
@@ -306,6 +310,9 @@ void gc_init();
 // Execute one block of rs275/ngc/g-code
 Error gc_execute_line(char* line);
 
+// Execute a G1 block whose move carries one laser power value per pixel, as in mc_raster()
+Error gc_execute_raster(char* line, const uint8_t* pixels, uint16_t n_pixels);
+
 // Set g-code parser position. Input in steps.
 void gc_sync_position();
 
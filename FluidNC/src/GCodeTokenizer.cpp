@@ -0,0 +1,181 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "GCodeTokenizer.h"
+
+#include "NutsBolts.h"  // decimal_to_float()
+#include "Logging.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+static void gcode_comment_msg(const char* comment, size_t len) {
+    const size_t offset = 4;  // ignore "MSG_" part of comment
+    char         msg[80];
+    bool         found = false;
+    for (size_t i = 0; i + 3 <= len && !found; i++) {
+        found = strncmp(comment + i, "MSG", 3) == 0;
+    }
+    if (found) {
+        size_t n = len > offset ? len - offset : 0;
+        if (n >= sizeof(msg)) {
+            n = sizeof(msg) - 1;
+        }
+        memcpy(msg, comment + offset, n);
+        msg[n] = '\0';
+        log_info("GCode Comment..." << msg);
+    }
+}
+
+namespace {
+    // Walks the significant characters of a line, in upper case
+    class Cursor {
+        const char* _p;
+
+        // Moves past whitespace and comments to the next significant character
+        char skip() {
+            const char* comment = nullptr;  // The character after an open (
+            for (;; _p++) {
+                char c = *_p;
+                if (c == '\0') {
+                    if (comment) {
+                        // Unterminated ( comment
+                        gcode_comment_msg(comment, _p - comment);
+                    }
+                    return c;
+                }
+                if (isspace((unsigned char)c)) {
+                    continue;
+                }
+                switch (c) {
+                    case ')':
+                        if (comment) {
+                            gcode_comment_msg(comment, _p - comment);
+                            comment = nullptr;
+                        }
+                        // Strip out ) that does not follow a (
+                        continue;
+                    case '(':
+                        comment = _p + 1;
+                        continue;
+                    case ';':
+                        // NOTE: ';' comment to EOL is a LinuxCNC definition. Not NIST.
+                        _p = "";
+                        return '\0';
+                    case '%':
+                        // Program start-end percent sign NOT SUPPORTED.
+                        continue;
+                }
+                if (!comment) {
+                    return toupper(c);
+                }
+            }
+        }
+
+    public:
+        explicit Cursor(const char* line) : _p(line) {}
+
+        // The current character, or '\0' at the end of the line
+        inline char peek() {
+            char c = *_p;
+            if (c >= 'a' && c <= 'z') {
+                return c - 'a' + 'A';
+            }
+            if (c > ' ' && c != '(' && c != ')' && c != ';' && c != '%') {
+                return c;
+            }
+            return skip();
+        }
+
+        // Only valid after peek() has returned a character other than '\0'
+        inline void advance() { _p++; }
+    };
+}
+
+// The same number syntax as read_float(), over the significant characters only
+static bool read_number(Cursor& in, float& value) {
+    char c          = in.peek();
+    bool isnegative = false;
+    if (c == '-') {
+        isnegative = true;
+        in.advance();
+    } else if (c == '+') {
+        in.advance();
+    }
+
+    uint32_t intval    = 0;
+    int8_t   exp       = 0;
+    size_t   ndigit    = 0;
+    bool     isdecimal = false;
+    while (true) {
+        c         = in.peek();
+        uint8_t d = uint8_t(c - '0');
+        if (d <= 9) {
+            ndigit++;
+            if (ndigit <= MAX_INT_DIGITS) {
+                if (isdecimal) {
+                    exp--;
+                }
+                intval = intval * 10 + d;
+            } else if (!isdecimal) {
+                exp++;  // Drop overflow digits
+            }
+        } else if (c == '.' && !isdecimal) {
+            isdecimal = true;
+        } else {
+            break;
+        }
+        in.advance();
+    }
+    if (!ndigit) {
+        return false;
+    }
+    float fval = decimal_to_float(intval, exp);
+    value      = isnegative ? -fval : fval;
+    return true;
+}
+
+void gc_tokenize(const char* line, gc_words_t& words) {
+    Cursor in(line);
+    words.count = 0;
+    words.error = Error::Ok;
+    words.jog   = false;
+
+    if (in.peek() == '$') {
+        // Jog lines start with $J=, which is not a word
+        words.jog = true;
+        for (int i = 0; i < 3 && in.peek() != '\0'; i++) {
+            in.advance();
+        }
+    }
+
+    char letter;
+    while ((letter = in.peek()) != '\0') {
+        if (letter < 'A' || letter > 'Z') {
+            words.error = Error::ExpectedCommandLetter;
+            break;
+        }
+        in.advance();
+        float value;
+        if (!read_number(in, value)) {
+            words.error = Error::BadNumberFormat;
+            break;
+        }
+        if (words.count == gc_words_t::maxWords) {
+            words.error = Error::Overflow;
+            break;
+        }
+        gc_word_t& word = words.words[words.count++];
+        word.letter     = letter;
+        word.value      = value;
+        word.int_value  = int8_t(truncf(value));
+        // NOTE: Rounding must be used to catch small floating point errors.
+        word.mantissa = lroundf(100 * (value - word.int_value));
+    }
+    if (words.error != Error::Ok) {
+        // Comments after the error are still shown
+        while (in.peek() != '\0') {
+            in.advance();
+        }
+    }
+}
@@ -0,0 +1,44 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  GCodeTokenizer.h - splits a G-code line into words
+
+  The tokenizer reads the line as it came from the channel, in one pass and without
+  copying or editing it.  Whitespace, ( ) comments, ; comments, % and letter case are
+  handled on the fly, with the same meaning that they have always had, so "x 1 0.5"
+  is still X10.5.  Each word is converted once into the forms that the parser uses:
+  the float value, as read_float() would compute it, and the integer part and
+  mantissa x100 that identify Gxx.x and Mxx commands.
+
+  An error does not stop the word list.  The words in front of the error are kept
+  and the error is recorded, so gc_execute_line() reports the first problem in the
+  line, in the same order as before.
+*/
+
+#include "Error.h"
+#include "Protocol.h"  // LINE_BUFFER_SIZE
+
+#include <cstdint>
+#include <cstddef>
+
+struct gc_word_t {
+    char     letter;     // Upper case
+    uint8_t  int_value;  // Integer part, as a G or M command number
+    uint16_t mantissa;   // Fractional part x100, rounded, e.g. 10 for G38.1
+    float    value;
+};
+
+struct gc_words_t {
+    // Every word takes at least two characters
+    static const size_t maxWords = LINE_BUFFER_SIZE / 2;
+
+    gc_word_t words[maxWords];
+    size_t    count;
+    Error     error;  // Error::Ok, or the problem that follows the last word
+    bool      jog;    // The line began with $J=, which is not part of the words
+};
+
+// Fills words from a NUL-terminated line.  MSG comments are logged as they are found.
+void gc_tokenize(const char* line, gc_words_t& words);
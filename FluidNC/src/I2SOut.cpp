@@ -4,6 +4,8 @@
 // Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
 
 #include "I2SOut.h"
+#include "StepperStats.h"
+#include "TaskStats.h"
 
 #include <sdkconfig.h>
 
@@ -478,10 +480,13 @@ static void IRAM_ATTR i2s_out_intr_handler(void* arg) {
 //
 static void i2sOutTask(void* parameter) {
     lldesc_t* dma_desc;
+    TaskStats::start(TaskStats::I2S);
     while (1) {
         // Wait a DMA complete event from I2S isr
         // (Block until a DMA transfer has complete)
+        TaskStats::sleep(TaskStats::I2S);
         xQueueReceive(o_dma.queue, &dma_desc, portMAX_DELAY);
+        TaskStats::wake(TaskStats::I2S);
         o_dma.current = (uint32_t*)(dma_desc->buf);
         // It reuses the oldest (just transferred) buffer with the name "current"
         // and fills the buffer for later DMA.
@@ -497,7 +502,9 @@ static void i2sOutTask(void* parameter) {
             // the generation of the buffer is interrupted (the buffer length is shortened slightly)
             // and the pulse generation is postponed until the next buffer is filled.
             //
+            auto fillStarted = StepperStats::start();
             i2s_fillout_dma_buffer(dma_desc);
+            StepperStats::stop(StepperStats::I2SFill, fillStarted);
             dma_desc->length = o_dma.rw_pos * I2S_SAMPLE_SIZE;
         } else if (i2s_out_pulser_status == WAITING) {
             if (dma_desc->qe.stqe_next == NULL) {
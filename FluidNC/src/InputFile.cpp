@@ -5,37 +5,148 @@
 
 #include "Report.h"
 
+#include "Config.h"  // SUPPORT_TASK_CORE
+
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <cstring>
+
+struct ReadRequest {
+    InputFile* file;
+    int        block;
+};
+
+// One reader serves every open file.  Each file has at most two requests queued.
+static QueueHandle_t readQueue = nullptr;
+
+void InputFile::readerTask(void* parameters) {
+    ReadRequest req;
+    while (true) {
+        if (xQueueReceive(readQueue, &req, portMAX_DELAY)) {
+            req.file->fill(req.block);
+        }
+    }
+}
+
 InputFile::InputFile(const char* defaultFs, const char* path, WebUI::AuthenticationLevel auth_level, Channel& out) :
-    FileStream(path, "r", defaultFs), _auth_level(auth_level), _out(out), _line_num(0) {}
+    FileStream(path, "r", defaultFs), _auth_level(auth_level), _out(out), _line_num(0) {
+    if (!readQueue) {
+        readQueue = xQueueCreate(4, sizeof(ReadRequest));
+        xTaskCreatePinnedToCore(readerTask,        // task
+                                "fileReader",      // name for task
+                                4096,              // size of task stack
+                                NULL,              // parameters
+                                1,                 // priority
+                                NULL,              // task handle
+                                SUPPORT_TASK_CORE  // core
+        );
+    }
+    for (int i = 0; i < 2; i++) {
+        _blocks[i].data = new char[blockSize];
+        request(i);
+    }
+}
+
+void InputFile::request(int block) {
+    _blocks[block].state = Requested;
+    ReadRequest req      = { this, block };
+    xQueueSend(readQueue, &req, portMAX_DELAY);
+}
+
+// Runs in the reader task
+void InputFile::fill(int block) {
+    auto& b = _blocks[block];
+    b.len   = FileStream::read(b.data, blockSize);
+    b.state = Ready;
+}
+
 /*
-  Read a line from the file
+  Take the next line from the read-ahead blocks
   Returns Error::Ok if a line was read, even if the line was empty.
   Returns Error::EOF on end of file.
-  Returns other Error code on error, after displaying a message.
+  Returns Error::AnotherInterfaceBusy if wait is false and the line continues into
+  a block that has not been read yet.  The start of the line is kept in _line, and
+  the next call picks up where this one left off.
+  Returns other Error code on error.
 */
-Error InputFile::readLine(char* line, int maxlen) {
-    ++_line_num;
-    int len = 0;
-    int c;
-    while ((c = read()) >= 0) {
-        if (len >= maxlen) {
-            return Error::LineLengthExceeded;
+Error InputFile::nextLine(char* line, int maxlen, bool wait) {
+    while (true) {
+        auto& b = _blocks[_current];
+        if (b.state == Idle) {
+            // Past the end of the file.  The last line might not have a newline.
+            if (_linelen == 0) {
+                return Error::Eof;
+            }
+            break;
         }
-        if (c == '\r') {
+        if (b.state == Requested) {
+            if (!wait) {
+                return Error::AnotherInterfaceBusy;
+            }
+            vTaskDelay(1);
             continue;
         }
-        if (c == '\n') {
+
+        const char* start = b.data + _offset;
+        size_t      avail = b.len - _offset;
+        auto        nl    = static_cast<const char*>(memchr(start, '\n', avail));
+        size_t      len   = nl ? nl - start : avail;
+        if (_linelen + len >= size_t(maxlen)) {
+            ++_line_num;
+            _linelen = 0;
+            return Error::LineLengthExceeded;
+        }
+        memcpy(_line + _linelen, start, len);
+        _linelen += len;
+        if (nl) {
+            ++len;  // Consume the newline too
+        }
+        _offset += len;
+        _consumed += len;
+
+        if (_offset == b.len) {
+            // The block is used up, so it can receive the block after the other one
+            if (b.len < blockSize) {
+                _lastBlock = true;
+            }
+            if (_lastBlock) {
+                b.state = Idle;
+            } else {
+                request(_current);
+            }
+            _current ^= 1;
+            _offset = 0;
+        }
+        if (nl) {
             break;
         }
-        line[len++] = c;
+    }
+
+    ++_line_num;
+    size_t len = 0;
+    for (size_t i = 0; i < _linelen; i++) {
+        if (_line[i] != '\r') {
+            line[len++] = _line[i];
+        }
     }
     line[len] = '\0';
-    return len || c >= 0 ? Error::Ok : Error::Eof;
+    _linelen  = 0;
+    return Error::Ok;
+}
+
+/*
+  Read a line from the file
+  Returns Error::Ok if a line was read, even if the line was empty.
+  Returns Error::EOF on end of file.
+  Returns other Error code on error, after displaying a message.
+*/
+Error InputFile::readLine(char* line, int maxlen) {
+    return nextLine(line, maxlen, true);
 }
 
 // return a percentage complete 50.5 = 50.5%
 float InputFile::percent_complete() {
-    return (float)position() / (float)size() * 100.0f;
+    return (float)_consumed / (float)size() * 100.0f;
 }
 
 void InputFile::ack(Error status) {
@@ -52,10 +163,25 @@ void InputFile::ack(Error status) {
     _readyNext = true;
 }
 
-std::string InputFile::_progress = "";
+InputFile::Progress InputFile::_progress;
+
+void InputFile::updateProgress() {
+    if (_progress.file != this) {
+        // This job just started, or a job that it ran has finished
+        _progress.file = nullptr;
+        _progress.size = size();
+        strncpy(_progress.path, path().c_str(), sizeof(_progress.path) - 1);
+        _progress.path[sizeof(_progress.path) - 1] = '\0';
+        _progress.file                             = this;
+    }
+    _progress.consumed = _consumed;
+    _progress.line     = _line_num;
+}
 
-#include <sstream>
-#include <iomanip>
+void InputFile::clearProgress() {
+    const InputFile* self = this;
+    _progress.file.compare_exchange_strong(self, nullptr);
+}
 
 Channel* InputFile::pollLine(char* line) {
     // File input never returns realtime characters, so we do nothing
@@ -63,21 +189,24 @@ Channel* InputFile::pollLine(char* line) {
     if (!_readyNext || !line) {
         return nullptr;
     }
-    switch (auto err = readLine(line, Channel::maxLine)) {
-        case Error::Ok: {
-            std::ostringstream s;
-            s << "SD:" << std::fixed << std::setprecision(2) << percent_complete() << "," << path().c_str();
-            _progress = s.str();
-        }
+    switch (auto err = nextLine(line, Channel::maxLine, false)) {
+        case Error::AnotherInterfaceBusy:
+            // The reader task has not caught up yet, so try again later
+            return nullptr;
+        case Error::Ok:
+            updateProgress();
+            // The next line waits for the ack, so an error can stop the job
+            // before anything after it is executed
+            _readyNext = false;
             return &allChannels;
         case Error::Eof:
-            _progress = "";
+            clearProgress();
             _notifyf("File job done", "%s file job succeeded", path());
             log_msg(path() << " file job succeeded");
             allChannels.kill(this);
             return nullptr;
         default:
-            _progress = "";
+            clearProgress();
             log_error(static_cast<int>(err) << " (" << errorString(err) << ") in " << path() << " at line " << getLineNumber());
             allChannels.kill(this);
             return nullptr;
@@ -92,5 +221,12 @@ void InputFile::stopJob() {
 }
 
 InputFile::~InputFile() {
-    _progress = "";
+    // The reader task might still be filling a block
+    for (auto& b : _blocks) {
+        while (b.state == Requested) {
+            vTaskDelay(1);
+        }
+        delete[] b.data;
+    }
+    clearProgress();
 }
@@ -8,6 +8,10 @@
 //  - For reporting the progress of GCode execution, counts the number of lines read and
 //    the percentage of the file size that has currently been read.
 //  - For reporting status, remembers the I/O channel that started the process of using the file.
+//  - Reads ahead.  The file is read in large blocks by a background task, into two buffers
+//    that take turns, so lines are split from memory while the next block is read.  On SD
+//    cards over SPI, that keeps the card busy in parallel with G-code execution instead of
+//    stalling the poller for every block.
 // FileStream's Channel member is not that same Channel that FileStream ultimately
 // inherits from; rather it is a separate channel that is use for status reporting.
 
@@ -17,6 +21,7 @@
 #include "FileStream.h"  // FileStream and Channel
 #include "Error.h"
 
+#include <atomic>
 #include <cstdint>
 
 class InputFile : public FileStream {
@@ -30,8 +35,42 @@ private:
     uint32_t _line_num;  // the most recent line number read
     bool     _readyNext = true;
 
+    // Read-ahead blocks.  A block is Requested when it is queued for the reader task,
+    // which reads the next part of the file into it and marks it Ready.  The block is
+    // then consumed and requested again, unless it was the end of the file.
+    static const size_t blockSize = 2048;
+    enum BlockState : uint8_t { Idle, Requested, Ready };
+    struct Block {
+        char*                   data = nullptr;
+        size_t                  len  = 0;
+        std::atomic<BlockState> state { Idle };
+    };
+    Block  _blocks[2];
+    int    _current   = 0;      // The block that lines are taken from
+    size_t _offset    = 0;      // Next character in the current block
+    size_t _consumed  = 0;      // Bytes of the file that are in lines already returned
+    bool   _lastBlock = false;  // A short block was read, so there is nothing after it
+
+    void  request(int block);
+    void  fill(int block);
+    Error nextLine(char* line, int maxlen, bool wait);
+    void  updateProgress();
+    void  clearProgress();
+
+    // Serves request() for every InputFile, in order
+    static void readerTask(void* parameters);
+
 public:
-    static std::string _progress;
+    // Progress of the running file job, for status reports.  pollLine() only stores
+    // the numbers; report_realtime_status() formats them when a report is sent.
+    struct Progress {
+        std::atomic<const InputFile*> file { nullptr };  // nullptr when no job is running
+        std::atomic<size_t>           consumed { 0 };
+        std::atomic<uint32_t>         line { 0 };
+        size_t                        size = 0;
+        char                          path[128];
+    };
+    static Progress _progress;
 
     // fsname is the default file system on which the file is located, in case the path does not specify
     // path is the full path to the file
@@ -63,6 +102,8 @@ public:
 
     WebUI::AuthenticationLevel getAuthLevel() { return _auth_level; }
 
+    WebUI::AuthenticationLevel authLevel() override { return _auth_level; }
+
     // Channel methods
     size_t   write(uint8_t c) override { return 0; }
     void     ack(Error status) override;
@@ -32,6 +32,7 @@ namespace Kinematics {
         bool canHome(AxisMask axisMask) override;
         void releaseMotors(AxisMask axisMask, MotorMask motors) override;
         bool limitReached(AxisMask& axisMask, MotorMask& motors, MotorMask limited) override;
+        bool motorSpaceIsCartesian() override { return true; }
 
         // Configuration handlers:
         void afterParse() override {}
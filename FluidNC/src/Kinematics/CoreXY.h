@@ -32,6 +32,7 @@ namespace Kinematics {
         void         motors_to_cartesian(float* cartesian, float* motors, int n_axis) override;
 
         bool canHome(AxisMask axisMask) override;
+        bool motorSpaceIsCartesian() override { return false; }
         void releaseMotors(AxisMask axisMask, MotorMask motors) override;
         bool limitReached(AxisMask& axisMask, MotorMask& motors, MotorMask limited);
 
@@ -23,6 +23,11 @@ namespace Kinematics {
         return _system->canHome(axisMask);
     }
 
+    bool Kinematics::motorSpaceIsCartesian() {
+        Assert(_system != nullptr, "No kinematic system");
+        return _system->motorSpaceIsCartesian();
+    }
+
     void Kinematics::releaseMotors(AxisMask axisMask, MotorMask motors) {
         Assert(_system != nullptr, "No kinematic system");
         _system->releaseMotors(axisMask, motors);
@@ -51,6 +51,7 @@ namespace Kinematics {
         bool canHome(AxisMask axisMask);
         void releaseMotors(AxisMask axisMask, MotorMask motors);
         bool limitReached(AxisMask& axisMask, MotorMask& motors, MotorMask limited);
+        bool motorSpaceIsCartesian();
 
     private:
         ::Kinematics::KinematicSystem* _system = nullptr;
@@ -77,6 +78,10 @@ namespace Kinematics {
         virtual void releaseMotors(AxisMask axisMask, MotorMask motors) {}
         virtual bool limitReached(AxisMask& axisMask, MotorMask& motors, MotorMask limited) { return false; }
 
+        // True if motor positions are cartesian positions, so that the planner can follow
+        // arcs in motor space
+        virtual bool motorSpaceIsCartesian() { return false; }
+
         // Configuration interface.
         void afterParse() override {}
         void group(Configuration::HandlerBase& handler) override {}
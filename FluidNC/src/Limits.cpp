@@ -9,6 +9,7 @@
 #include "System.h"         // sys.*
 #include "Protocol.h"       // protocol_execute_realtime
 #include "Platform.h"       // WEAK_LINK
+#include "TaskStats.h"      // TaskStats::sleep()
 
 #include <freertos/task.h>
 #include <freertos/queue.h>
@@ -150,12 +151,15 @@ void limits_soft_check(float* cartesian) {
 
 #ifdef LATER  // We need to rethink debouncing
 void limitCheckTask(void* pvParameters) {
+    TaskStats::start(TaskStats::Limits);
     while (true) {
         std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);  // read fence for settings
 
         int evt;
+        TaskStats::sleep(TaskStats::Limits);
         xQueueReceive(limit_sw_queue, &evt, portMAX_DELAY);            // block until receive queue
         vTaskDelay(config->_softwareDebounceMs / portTICK_PERIOD_MS);  // delay a while
+        TaskStats::wake(TaskStats::Limits);
         auto switch_state = limits_get_state();
         if (switch_state) {
             log_debug("Limit Switch State " << to_hex(switch_state));
@@ -6,24 +6,89 @@
 #include "Serial.h"
 #include "SettingsDefinitions.h"
 
+#include <cstring>
+
 bool atMsgLevel(MsgLevel level) {
     return message_level == nullptr || message_level->get() >= level;
 }
 
-LogStream::LogStream(Channel& channel, const char* name) : _channel(channel) {
-    _line = new std::string();
+// Bit n of slotsInUse is set while arena[n] holds a message
+static char                  arena[LogStream::nSlots][LogStream::slotSize];
+static std::atomic<uint32_t> slotsInUse { 0 };
+
+std::atomic<uint32_t> log_arena_full { 0 };
+std::atomic<uint32_t> log_oversize { 0 };
+
+static int claim_slot() {
+    const uint32_t all  = (1u << LogStream::nSlots) - 1;
+    uint32_t       used = slotsInUse;
+    while (true) {
+        uint32_t free = ~used & all;
+        if (!free) {
+            return -1;
+        }
+        int slot = __builtin_ctz(free);
+        if (slotsInUse.compare_exchange_weak(used, used | (1u << slot))) {
+            return slot;
+        }
+    }
+}
+
+LogStream::LogStream(Channel& channel, const char* name) : _channel(channel), _slot(claim_slot()) {
+    if (_slot < 0) {
+        ++log_arena_full;
+        _spill = new std::string();
+    }
     print(name);
 }
 LogStream::LogStream(const char* name) : LogStream(allChannels, name) {}
 
+char* LogStream::slot() {
+    return arena[_slot];
+}
+
+// Moves the message to the heap, and frees the slot for another message
+void LogStream::spill() {
+    ++log_oversize;
+    _spill = new std::string(slot(), _len);
+    slotsInUse &= ~(1u << _slot);
+    _slot = -1;
+}
+
 size_t LogStream::write(uint8_t c) {
-    *_line += (char)c;
-    return 1;
+    return write(&c, 1);
+}
+
+size_t LogStream::write(const uint8_t* buffer, size_t length) {
+    // Room is kept for the closing ] and the NUL
+    if (!_spill && _len + length > slotSize - 2) {
+        spill();
+    }
+    if (_spill) {
+        _spill->append(reinterpret_cast<const char*>(buffer), length);
+    } else {
+        memcpy(slot() + _len, buffer, length);
+        _len += length;
+    }
+    return length;
 }
 
 LogStream::~LogStream() {
-    if ((*_line).length() && (*_line)[0] == '[') {
-        *_line += ']';
+    if (_spill) {
+        if (_spill->length() && (*_spill)[0] == '[') {
+            *_spill += ']';
+        }
+        send_line(_channel, _spill->c_str());
+        delete _spill;
+    } else {
+        char* line = slot();
+        if (_len && line[0] == '[') {
+            line[_len++] = ']';
+        }
+        line[_len] = '\0';
+        send_line(_channel, line);
+    }
+    if (_slot >= 0) {
+        slotsInUse &= ~(1u << _slot);
     }
-    send_line(_channel, _line);
 }
@@ -4,6 +4,8 @@
 #pragma once
 
 #include <cstdint>
+#include <atomic>
+#include <string>
 
 class Channel;
 
@@ -31,18 +33,36 @@ enum MsgLevel {
 
 #include "MyIOStream.h"
 
+// A message is built in a slot of a static arena, so logging does not touch the
+// heap.  A message that outgrows its slot, or that finds every slot in use,
+// continues in a std::string on the heap, and that is counted.
 class LogStream : public Print {
 public:
+    static const int    nSlots   = 8;
+    static const size_t slotSize = 256;
+
     LogStream(Channel& channel, const char* name);
     LogStream(const char* name);
     size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t length) override;
+    using Print::write;
     ~LogStream();
 
 private:
     Channel&     _channel;
-    std::string* _line;
+    int          _slot;            // -1 if no slot was free
+    size_t       _len   = 0;       // Characters in the slot
+    std::string* _spill = nullptr;  // Where the message goes once it leaves the slot
+
+    char* slot();
+    void  spill();
 };
 
+// Messages that had to use the heap because every slot was in use, or because
+// they were too long for a slot
+extern std::atomic<uint32_t> log_arena_full;
+extern std::atomic<uint32_t> log_oversize;
+
 extern bool atMsgLevel(MsgLevel level);
 
 // clang-format off
@@ -7,6 +7,8 @@
 #include "../Stepper.h"     // stepper_id_t
 #include "MachineConfig.h"  // config->
 #include "../Limits.h"
+#include "../I2SOut.h"             // i2s_out_write()
+#include "Driver/fluidnc_gpio.h"  // gpio_write(), gpio_write_masks()
 
 EnumItem axisType[] = { { 0, "X" }, { 1, "Y" }, { 2, "Z" }, { 3, "A" }, { 4, "B" }, { 5, "C" }, EnumItem(0) };
 
@@ -14,10 +16,11 @@ namespace Machine {
     MotorMask Axes::posLimitMask = 0;
     MotorMask Axes::negLimitMask = 0;
     MotorMask Axes::homingMask   = 0;
+    AxisMask  Axes::shapedMask   = 0;
     MotorMask Axes::limitMask    = 0;
     MotorMask Axes::motorMask    = 0;
 
-    Axes::Axes() : _axis() {
+    Axes::Axes() : _axis(), _firstTarget() {
         for (int i = 0; i < MAX_N_AXIS; ++i) {
             _axis[i] = nullptr;
         }
@@ -47,6 +50,76 @@ namespace Machine {
         }
 
         config_motors();
+
+        compile_step_targets();
+    }
+
+    // Classifies a pin that the step fan-out table may write directly
+    static Axes::PinKind pin_kind(const Pin* pin) {
+        if (!pin || pin->undefined()) {
+            return pin ? Axes::NoPin : Axes::DriverPin;
+        }
+        auto caps = pin->capabilities();
+        if (caps.has(Pin::Capabilities::I2S)) {
+            return Axes::I2SOPin;
+        }
+        if (caps.has(Pin::Capabilities::Native)) {
+            return Axes::GpioPin;
+        }
+        return Axes::DriverPin;
+    }
+
+    // Builds the step fan-out table from the motors of each axis.  Must be called after
+    // the motor drivers have initialized their pins.
+    void Axes::compile_step_targets() {
+        // With the Batched engine, all the GPIO writes of a tick are collected and then
+        // made with one register store per GPIO bank
+        auto gpioKind = config->_stepping->_engine == Stepping::BATCHED ? GpioMaskPin : GpioPin;
+        _batched      = false;
+
+        int n = 0;
+        for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+            _firstTarget[axis] = n;
+            if (axis >= _numberAxis) {
+                continue;
+            }
+            for (int motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
+                auto m = _axis[axis]->_motors[motor];
+                if (!m) {
+                    continue;
+                }
+                auto& t    = _stepTargets[n++];
+                t.motor    = m;
+                t.driver   = m->_driver;
+                t.stepKind = DriverPin;
+                t.dirKind  = DriverPin;
+
+                auto stepPin = m->_driver->stepPin();
+                auto kind    = pin_kind(stepPin);
+                if (kind == GpioPin || kind == I2SOPin) {
+                    t.stepPin    = stepPin->getNative(kind == GpioPin ? Pin::Capabilities::Native : Pin::Capabilities::I2S);
+                    t.stepActive = !stepPin->getAttr().has(Pin::Attr::ActiveLow);
+                    t.stepKind   = kind == GpioPin ? gpioKind : kind;
+                }
+
+                auto dirPin = m->_driver->dirPin();
+                kind        = pin_kind(dirPin);
+                if (kind == GpioPin || kind == I2SOPin) {
+                    t.dirPin    = dirPin->getNative(kind == GpioPin ? Pin::Capabilities::Native : Pin::Capabilities::I2S);
+                    t.dirInvert = dirPin->getAttr().has(Pin::Attr::ActiveLow);
+                    kind        = kind == GpioPin ? gpioKind : kind;
+                }
+                t.dirKind = kind;
+
+                _batched = _batched || t.stepKind == GpioMaskPin || t.dirKind == GpioMaskPin;
+            }
+        }
+        if (gpioKind == GpioMaskPin && !_batched) {
+            log_warn("Batched stepping has no GPIO step or direction pins to batch");
+        }
+        _firstTarget[MAX_N_AXIS] = n;
+        _previousDir             = 255;
+        _steppedAxes             = 0;
     }
 
     void IRAM_ATTR Axes::set_disable(int axis, bool disable) {
@@ -91,58 +164,107 @@ namespace Machine {
         return motorsCanHome;
     }
 
-    void IRAM_ATTR Axes::step(uint8_t step_mask, uint8_t dir_mask) {
-        auto n_axis = _numberAxis;
-        //log_info("motors_set_direction_pins:0x%02X", onMask);
-
-        // Set the direction pins, but optimize for the common
-        // situation where the direction bits haven't changed.
-        static uint8_t previous_dir = 255;  // should never be this value
-        if (dir_mask != previous_dir) {
-            previous_dir = dir_mask;
+    // set and clear collect the GpioMaskPin writes, one word per GPIO bank
+    static inline void IRAM_ATTR write_pin(uint8_t kind, pinnum_t pin, bool level, uint32_t* set, uint32_t* clear) {
+        if (kind == Axes::GpioMaskPin) {
+            uint32_t bit = 1u << (pin & 31);
+            if (level) {
+                set[pin >> 5] |= bit;
+            } else {
+                clear[pin >> 5] |= bit;
+            }
+        } else if (kind == Axes::GpioPin) {
+            gpio_write(pin, level);
+        } else {
+            i2s_out_write(pin, level);
+        }
+    }
 
-            for (int axis = X_AXIS; axis < n_axis; axis++) {
+    void IRAM_ATTR Axes::step(uint8_t step_mask, uint8_t dir_mask) {
+        AxisMask axes     = (1 << _numberAxis) - 1;
+        uint32_t set[2]   = { 0, 0 };
+        uint32_t clear[2] = { 0, 0 };
+
+        // Set the direction pins of the axes whose direction changed
+        AxisMask changed = (dir_mask ^ _previousDir) & axes;
+        if (changed) {
+            _previousDir = dir_mask;
+
+            for (int axis = X_AXIS; changed; axis++, changed >>= 1) {
+                if (!(changed & 1)) {
+                    continue;
+                }
                 bool thisDir = bitnum_is_true(dir_mask, axis);
-
-                for (size_t motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
-                    auto m = _axis[axis]->_motors[motor];
-                    if (m) {
-                        m->_driver->set_direction(thisDir);
+                for (int i = _firstTarget[axis]; i < _firstTarget[axis + 1]; i++) {
+                    auto& t = _stepTargets[i];
+                    if (t.dirKind == DriverPin) {
+                        t.driver->set_direction(thisDir);
+                    } else if (t.dirKind != NoPin) {
+                        write_pin(t.dirKind, t.dirPin, thisDir ^ t.dirInvert, set, clear);
                     }
                 }
             }
+            if (_batched) {
+                gpio_write_masks(set, clear);
+                set[0] = set[1] = clear[0] = clear[1] = 0;
+            }
             config->_stepping->waitDirection();
         }
 
         // Turn on step pulses for motors that are supposed to step now
-        for (size_t axis = X_AXIS; axis < n_axis; axis++) {
-            if (bitnum_is_true(step_mask, axis)) {
-                bool dir = bitnum_is_true(dir_mask, axis);
-
-                auto a = _axis[axis];
-                for (size_t motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
-                    auto m = a->_motors[motor];
-                    if (m) {
-                        m->step(dir);
-                    }
+        step_mask &= axes;
+        _steppedAxes = step_mask;
+        for (int axis = X_AXIS; step_mask; axis++, step_mask >>= 1) {
+            if (!(step_mask & 1)) {
+                continue;
+            }
+            int32_t delta = bitnum_is_true(dir_mask, axis) ? -1 : 1;
+            for (int i = _firstTarget[axis]; i < _firstTarget[axis + 1]; i++) {
+                auto& t = _stepTargets[i];
+                auto  m = t.motor;
+                // Skip steps based on limit pins
+                // _blocked is for asymmetric pulloff
+                // _limited is for limit pins
+                if (m->_blocked || m->_limited) {
+                    continue;
+                }
+                if (t.stepKind == DriverPin) {
+                    t.driver->step();
+                } else {
+                    write_pin(t.stepKind, t.stepPin, t.stepActive, set, clear);
                 }
+                m->_steps += delta;
             }
         }
+        if (_batched) {
+            gpio_write_masks(set, clear);
+        }
         config->_stepping->startPulseTimer();
     }
 
-    // Turn all stepper pins off
+    // Turn off the step pins of the motors that were stepped
     void IRAM_ATTR Axes::unstep() {
         config->_stepping->waitPulse();
-        auto n_axis = _numberAxis;
-        for (size_t axis = X_AXIS; axis < n_axis; axis++) {
-            for (size_t motor = 0; motor < Axis::MAX_MOTORS_PER_AXIS; motor++) {
-                auto m = _axis[axis]->_motors[motor];
-                if (m) {
-                    m->_driver->unstep();
+        uint32_t set[2]   = { 0, 0 };
+        uint32_t clear[2] = { 0, 0 };
+        auto     stepped  = _steppedAxes;
+        for (int axis = X_AXIS; stepped; axis++, stepped >>= 1) {
+            if (!(stepped & 1)) {
+                continue;
+            }
+            for (int i = _firstTarget[axis]; i < _firstTarget[axis + 1]; i++) {
+                auto& t = _stepTargets[i];
+                if (t.stepKind == DriverPin) {
+                    t.driver->unstep();
+                } else {
+                    write_pin(t.stepKind, t.stepPin, !t.stepActive, set, clear);
                 }
             }
         }
+        if (_batched) {
+            gpio_write_masks(set, clear);
+        }
+        _steppedAxes = 0;
 
         config->_stepping->finishPulse();
     }
@@ -19,12 +19,22 @@ namespace Machine {
     public:
         static constexpr const char* _names = "XYZABC";
 
+        // How a step or direction signal reaches a motor
+        enum PinKind : uint8_t {
+            DriverPin = 0,  // Through the MotorDriver virtual methods
+            GpioPin,        // Written directly to a GPIO
+            I2SOPin,        // Written directly to the I2S output shift register
+            GpioMaskPin,    // Collected into GPIO set/clear masks that are written at once
+            NoPin,          // Not connected
+        };
+
         Axes();
 
         // Bitmasks to collect information about axes that have limits and homing
         static MotorMask posLimitMask;
         static MotorMask negLimitMask;
         static MotorMask homingMask;
+        static AxisMask  shapedMask;  // Axes with an input shaper
         static MotorMask limitMask;
         static MotorMask motorMask;
 
@@ -81,6 +91,29 @@ namespace Machine {
         void afterParse() override;
 
         ~Axes();
+
+    private:
+        // One entry of the step fan-out table.  The entries for each axis are contiguous,
+        // so a step tick only visits the motors of the axes that step, and the pin polarity
+        // is resolved when the table is compiled.
+        struct StepTarget {
+            Motor*                     motor;
+            MotorDrivers::MotorDriver* driver;
+            PinKind                    stepKind;
+            PinKind                    dirKind;
+            pinnum_t                   stepPin;
+            pinnum_t                   dirPin;
+            bool                       stepActive;  // Level that starts a step pulse
+            bool                       dirInvert;   // Level of the direction pin for a forward move
+        };
+
+        StepTarget _stepTargets[MAX_N_AXIS * Axis::MAX_MOTORS_PER_AXIS];
+        uint8_t    _firstTarget[MAX_N_AXIS + 1];  // Index of the first table entry of each axis
+        uint8_t    _previousDir = 255;            // should never be this value
+        AxisMask   _steppedAxes = 0;              // Axes whose step pins are active
+        bool       _batched     = false;          // Some pins are GpioMaskPin
+
+        void compile_step_targets();
     };
 }
 extern EnumItem axisType[];
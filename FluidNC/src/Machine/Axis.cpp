@@ -9,9 +9,11 @@ namespace Machine {
         handler.item("steps_per_mm", _stepsPerMm, 0.001, 100000.0);
         handler.item("max_rate_mm_per_min", _maxRate, 0.001, 100000.0);
         handler.item("acceleration_mm_per_sec2", _acceleration, 0.001, 100000.0);
+        handler.item("max_jerk_mm_per_sec3", _maxJerk, 0.0, 100000000.0);
         handler.item("max_travel_mm", _maxTravel, 0.1, 10000000.0);
         handler.item("soft_limits", _softLimits);
         handler.section("homing", _homing);
+        handler.section("shaper", _shaper);
 
         char tmp[7];
         tmp[0] = 0;
@@ -49,6 +51,10 @@ namespace Machine {
             _homing->init();
             set_bitnum(Axes::homingMask, _axis);
         }
+        if (_shaper) {
+            _shaper->init(_stepsPerMm * _maxRate / 60.0f);
+            set_bitnum(Axes::shapedMask, _axis);
+        }
 
         if (!_motors[0] && _motors[1]) {
             sys.state = State::ConfigAlarm;
@@ -123,5 +129,8 @@ namespace Machine {
                 delete _motors[i];
             }
         }
+        if (_shaper) {
+            delete _shaper;
+        }
     }
 }
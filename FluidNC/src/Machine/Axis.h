@@ -8,6 +8,7 @@
 // #include "Axes.h"
 #include "Motor.h"
 #include "Homing.h"
+#include "Shaper.h"
 
 namespace MotorDrivers {
     class MotorDriver;
@@ -29,10 +30,12 @@ namespace Machine {
 
         Motor*  _motors[MAX_MOTORS_PER_AXIS];
         Homing* _homing = nullptr;
+        Shaper* _shaper = nullptr;
 
         float _stepsPerMm   = 80.0f;
         float _maxRate      = 1000.0f;
         float _acceleration = 25.0f;
+        float _maxJerk      = 0.0f;  // 0 selects trapezoidal ramps
         float _maxTravel    = 1000.0f;
         bool  _softLimits   = false;
 
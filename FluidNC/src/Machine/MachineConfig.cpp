@@ -70,12 +70,15 @@ namespace Machine {
 
         // TODO: Consider putting these under a gcode: hierarchy level? Or motion control?
         handler.item("arc_tolerance_mm", _arcTolerance, 0.001, 1.0);
+        handler.item("arc_blocks", _arcBlocks);
         handler.item("junction_deviation_mm", _junctionDeviation, 0.01, 1.0);
         handler.item("verbose_errors", _verboseErrors);
         handler.item("report_inches", _reportInches);
         handler.item("enable_parking_override_control", _enableParkingOverrideControl);
         handler.item("use_line_numbers", _useLineNumbers);
-        handler.item("planner_blocks", _planner_blocks, 10, 120);
+        handler.item("gcode_fast_path", _gcodeFastPath);
+        handler.item("planner_blocks", _planner_blocks, 10, 4000);
+        handler.item("raster_buffer_bytes", _rasterBufferBytes, 0, 1000000);
     }
 
     void MachineConfig::afterParse() {
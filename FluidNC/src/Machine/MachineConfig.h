@@ -82,8 +82,20 @@ namespace Machine {
         bool  _verboseErrors     = false;
         bool  _reportInches      = false;
 
+        // Plan each arc as one block that the stepper follows exactly, instead of chords
+        // within arc_tolerance_mm. Only used with kinematics whose motor space is cartesian.
+        bool _arcBlocks = false;
+
+        // Execute modal G1 lines with only axis, N, F and S words without the full modal
+        // group checks, while the modal state stays the same as after the previous line.
+        bool _gcodeFastPath = false;
+
+        // Number of look-ahead blocks. Values much above 100 need PSRAM.
         size_t _planner_blocks = 16;
 
+        // Size of the pool that holds the per-pixel power of queued raster lines.
+        size_t _rasterBufferBytes = 4096;
+
         // Enables a special set of M-code commands that enables and disables the parking motion.
         // These are controlled by `M56`, `M56 P1`, or `M56 Px` to enable and `M56 P0` to disable.
         // The command is modal and will be set after a planner sync. Since it is GCode, it is
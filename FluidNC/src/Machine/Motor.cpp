@@ -67,18 +67,5 @@ namespace Machine {
 
     bool Motor::isReal() { return _driver->isReal(); }
 
-    void IRAM_ATTR Motor::step(bool reverse) {
-        // Skip steps based on limit pins
-        // _blocked is for asymmetric pulloff
-        // _limited is for limit pins
-        if (_blocked || _limited) {
-            return;
-        }
-        _driver->step();
-        _steps += reverse ? -1 : 1;
-    }
-
-    void IRAM_ATTR Motor::unstep() { _driver->unstep(); }
-
     Motor::~Motor() { delete _driver; }
 }
@@ -48,8 +48,6 @@ namespace Machine {
         void limitOtherAxis(int axis);
         void init();
         void config_motor();
-        void step(bool reverse);
-        void unstep();
         void block() { _blocked = true; }
         void unblock() { _blocked = false; }
         void unlimit() { _limited = false; }
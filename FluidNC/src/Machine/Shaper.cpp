@@ -0,0 +1,144 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "Shaper.h"
+#include "../Stepping.h"  // fStepperTimer
+
+#include "../Logging.h"
+
+#include <esp_attr.h>  // IRAM_ATTR
+#include <cmath>
+
+EnumItem shaperTypes[] = { { Machine::Shaper::ZV, "ZV" },
+                           { Machine::Shaper::ZVD, "ZVD" },
+                           { Machine::Shaper::MZV, "MZV" },
+                           EnumItem(Machine::Shaper::MZV) };
+
+namespace Machine {
+    void Shaper::group(Configuration::HandlerBase& handler) {
+        handler.item("type", _type, shaperTypes);
+        handler.item("frequency_hz", _frequency, 1.0, 500.0);
+        handler.item("damping_ratio", _damping, 0.0, 0.9);
+    }
+
+    void Shaper::init(float maxStepsPerSec) {
+        // Impulse amplitudes and times for the usual shapers, in units of the damped period
+        const float pi = 3.14159265f;
+        float       df = sqrtf(1.0f - _damping * _damping);
+        float       td = 1.0f / (_frequency * df);  // Damped period in seconds
+        float       amplitude[MAX_IMPULSES];
+        float       time[MAX_IMPULSES];
+
+        switch (_type) {
+            case ZV: {
+                float k      = expf(-_damping * pi / df);
+                _nImpulses   = 2;
+                amplitude[0] = 1.0f;
+                amplitude[1] = k;
+                time[0]      = 0.0f;
+                time[1]      = 0.5f * td;
+            } break;
+            case ZVD: {
+                float k      = expf(-_damping * pi / df);
+                _nImpulses   = 3;
+                amplitude[0] = 1.0f;
+                amplitude[1] = 2.0f * k;
+                amplitude[2] = k * k;
+                time[0]      = 0.0f;
+                time[1]      = 0.5f * td;
+                time[2]      = td;
+            } break;
+            default: {  // MZV
+                float k      = expf(-0.75f * _damping * pi / df);
+                float a1     = 1.0f - 1.0f / sqrtf(2.0f);
+                _nImpulses   = 3;
+                amplitude[0] = a1;
+                amplitude[1] = (sqrtf(2.0f) - 1.0f) * k;
+                amplitude[2] = a1 * k * k;
+                time[0]      = 0.0f;
+                time[1]      = 0.375f * td;
+                time[2]      = 0.75f * td;
+            } break;
+        }
+
+        float sum = 0.0f;
+        for (int i = 0; i < _nImpulses; i++) {
+            sum += amplitude[i];
+        }
+        // Normalize so that the amplitudes add up to exactly one step
+        int32_t remaining = ONE;
+        for (int i = 0; i < _nImpulses; i++) {
+            _amplitude[i] = i == _nImpulses - 1 ? remaining : int32_t(lroundf(amplitude[i] / sum * ONE));
+            remaining -= _amplitude[i];
+            _delay[i] = uint32_t(lroundf(time[i] * Stepping::fStepperTimer));
+        }
+
+        // The history must hold every step commanded during the longest delay
+        float    lagSecs  = time[_nImpulses - 1];
+        uint32_t capacity = uint32_t(lagSecs * maxStepsPerSec * 1.25f) + 16;
+        uint32_t size     = 16;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        if (_history) {
+            delete[] _history;
+        }
+        _history     = new Event[size];
+        _historyMask = size - 1;
+        reset();
+
+        log_info("    Shaper:" << shaperTypes[_type].name << " " << _frequency << "Hz damping:" << _damping
+                               << " delay:" << (lagSecs * 1000.0f) << "ms");
+    }
+
+    void Shaper::reset() {
+        _head = 0;
+        for (int i = 0; i < MAX_IMPULSES; i++) {
+            _cursor[i] = 0;
+        }
+        _error = 0;
+    }
+
+    void IRAM_ATTR Shaper::pass(int impulse) {
+        _error += _history[_cursor[impulse] & _historyMask].direction * _amplitude[impulse];
+        _cursor[impulse]++;
+    }
+
+    int IRAM_ATTR Shaper::tick(uint32_t now, bool step, bool reverse) {
+        if (step) {
+            uint32_t oldest = _cursor[_nImpulses - 1];
+            if (_head - oldest > _historyMask) {
+                // The history is full, which can only happen if the axis exceeds its maximum
+                // rate.  Apply the oldest step early rather than lose it.
+                for (int i = 0; i < _nImpulses; i++) {
+                    if (_cursor[i] == oldest) {
+                        pass(i);
+                    }
+                }
+            }
+            Event& event    = _history[_head & _historyMask];
+            event.time      = now;
+            event.direction = reverse ? -1 : 1;
+            _head++;
+        }
+
+        for (int i = 0; i < _nImpulses; i++) {
+            while (_cursor[i] != _head && int32_t(now - _history[_cursor[i] & _historyMask].time - _delay[i]) >= 0) {
+                pass(i);
+            }
+        }
+
+        // The ISR can emit at most one step per tick, so a larger error is worked off over
+        // the following ticks.
+        if (_error > HALF) {
+            _error -= ONE;
+            return 1;
+        }
+        if (_error < -HALF) {
+            _error += ONE;
+            return -1;
+        }
+        return 0;
+    }
+
+    bool IRAM_ATTR Shaper::busy() { return _cursor[_nImpulses - 1] != _head || _error > HALF || _error < -HALF; }
+}
@@ -0,0 +1,85 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  Shaper.h - per-axis input shaper
+
+  An input shaper convolves the commanded motion of an axis with a short train of
+  impulses whose amplitudes and delays are chosen so that the vibration each impulse
+  excites at the resonant frequency is cancelled by the vibration of the others.
+
+  The shaper runs in the step domain, in the stepper ISR.  The Bresenham steps of the
+  axis are recorded with their time, and a cursor per impulse walks that history at the
+  impulse's delay.  Each step that a cursor passes moves the shaped position by the
+  impulse amplitude, and the axis is stepped whenever the shaped position is more than
+  half a step away from the emitted position.  The shaped motion therefore lags the
+  commanded motion, but it always arrives at exactly the same step count.
+*/
+
+#include "../Configuration/Configurable.h"
+
+#include <cstdint>
+
+namespace Machine {
+    class Shaper : public Configuration::Configurable {
+    public:
+        enum Type {
+            ZV = 0,
+            ZVD,
+            MZV,
+        };
+
+        static const int MAX_IMPULSES = 3;
+
+        Shaper() = default;
+        ~Shaper() { delete[] _history; }
+
+        int   _type      = MZV;
+        float _frequency = 35.0f;  // Resonant frequency in Hz
+        float _damping   = 0.1f;   // Damping ratio of the resonance
+
+        // Computes the impulses and sizes the step history for the given maximum step rate
+        void init(float maxStepsPerSec);
+
+        // Clears the step history, dropping any shaped motion that has not been emitted
+        void reset();
+
+        // Called from the stepper ISR for every tick while the axis is shaped.  now is the
+        // time of the tick in stepping timer ticks.  Records the commanded step, if any,
+        // and returns +1 or -1 if the axis should step in the positive or negative
+        // direction on this tick, or 0 otherwise.
+        int tick(uint32_t now, bool step, bool reverse);
+
+        // True while there is shaped motion that has not been emitted
+        bool busy();
+
+        // Delay of the last impulse, in stepping timer ticks
+        uint32_t lag() { return _delay[_nImpulses - 1]; }
+
+        // Configuration system helpers:
+        void group(Configuration::HandlerBase& handler) override;
+
+    private:
+        struct Event {
+            uint32_t time;
+            int32_t  direction;  // +1 or -1
+        };
+
+        int      _nImpulses = 0;
+        int32_t  _amplitude[MAX_IMPULSES];  // Fixed point, sums to ONE
+        uint32_t _delay[MAX_IMPULSES];      // Stepping timer ticks
+
+        Event*   _history     = nullptr;
+        uint32_t _historyMask = 0;
+        uint32_t _head        = 0;  // Next event to record
+        uint32_t _cursor[MAX_IMPULSES];
+
+        int32_t _error = 0;  // Shaped position minus emitted position, fixed point
+
+        static const int32_t ONE  = 1 << 16;
+        static const int32_t HALF = ONE / 2;
+
+        void pass(int impulse);
+    };
+}
@@ -16,6 +16,7 @@
 #include "Settings.h"        // coords
 
 #include <cmath>
+#include <cstring>
 
 // M_PI is not defined in standard C/C++ but some compilers
 // support it anyway.  The following suppresses Intellisense
@@ -45,7 +46,7 @@ void mc_init() {
 // mc_linear and plan_buffer_line is done primarily to place non-planner-type functions from being
 // in the planner and to let backlash compensation or canned cycle integration simple and direct.
 // returns true if line was submitted to planner, or false if intentionally dropped.
-bool mc_move_motors(float* target, plan_line_data_t* pl_data) {
+bool mc_move_motors(float* target, plan_line_data_t* pl_data, const plan_arc_t* arc) {
     bool submitted_result = false;
     // store the plan data so it can be cancelled by the protocol system if needed
     mc_pl_data_inflight = pl_data;
@@ -85,7 +86,7 @@ bool mc_move_motors(float* target, plan_line_data_t* pl_data) {
 
     // Plan and queue motion into planner buffer
     if (mc_pl_data_inflight == pl_data) {
-        plan_buffer_line(target, pl_data);
+        plan_buffer_line(target, pl_data, arc);
         submitted_result = true;
     }
     mc_pl_data_inflight = NULL;
@@ -108,6 +109,52 @@ bool mc_linear(float* target, plan_line_data_t* pl_data, float* position) {
     return config->_kinematics->cartesian_to_motors(target, pl_data, position);
 }
 
+// Execute a raster line. The pixels are copied to the raster pool, waiting for room as the
+// machine works through earlier raster lines, and the line is queued as one raster block.
+bool mc_raster(float* target, plan_line_data_t* pl_data, float* position, const uint8_t* pixels, uint16_t n_pixels) {
+    if (!config->_kinematics->motorSpaceIsCartesian() || n_pixels == 0 || n_pixels > plan_raster_capacity()) {
+        return false;
+    }
+    uint8_t* raster;
+    while ((raster = plan_raster_alloc(n_pixels)) == nullptr) {
+        protocol_auto_cycle_start();
+        protocol_execute_realtime();
+        if (sys.abort) {
+            return false;
+        }
+    }
+    memcpy(raster, pixels, n_pixels);
+    pl_data->raster        = raster;
+    pl_data->raster_pixels = n_pixels;
+    bool submitted         = mc_linear(target, pl_data, position);
+    pl_data->raster        = nullptr;
+    pl_data->raster_pixels = 0;
+    return submitted;
+}
+
+// Soft limit check for an arc block. Besides the target, the arc reaches its extremes in the plane
+// where it crosses the axes through its center.
+static void arc_soft_check(float* target, float* position, float center_axis0, float center_axis1, const plan_arc_t& arc) {
+    limits_soft_check(target);
+
+    const float quarter = 0.5f * float(M_PI);
+    float       start   = MIN(arc.start_angle, arc.start_angle + arc.angular_travel);
+    float       end     = MAX(arc.start_angle, arc.start_angle + arc.angular_travel);
+    float       extreme[MAX_N_AXIS];
+    copyAxes(extreme, position);
+    // A full turn visits all four extremes, so more turns add nothing.
+    int first = int(ceilf(start / quarter));
+    for (int k = first; k < first + 4 && k * quarter < end; k++) {
+        float angle         = k * quarter;
+        extreme[arc.axis_0] = center_axis0 + arc.radius * cosf(angle);
+        extreme[arc.axis_1] = center_axis1 + arc.radius * sinf(angle);
+        limits_soft_check(extreme);
+        if (sys.abort) {
+            return;
+        }
+    }
+}
+
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, isclockwise boolean. Used
@@ -160,6 +207,25 @@ void mc_arc(float*            target,
         }
     }
 
+    if (config->_arcBlocks && config->_kinematics->motorSpaceIsCartesian()) {
+        // Plan the whole arc as one block. The stepper evaluates the arc for every segment.
+        plan_arc_t arc;
+        arc.axis_0         = axis_0;
+        arc.axis_1         = axis_1;
+        arc.radius         = hypot_f(r_axis0, r_axis1);
+        arc.start_angle    = atan2f(r_axis1, r_axis0);
+        arc.angular_travel = angular_travel;
+        arc.length         = 0.0f;
+        if (!pl_data->is_jog) {
+            arc_soft_check(target, position, center_axis0, center_axis1, arc);
+            if (sys.abort) {
+                return;
+            }
+        }
+        mc_move_motors(target, pl_data, &arc);
+        return;
+    }
+
     // NOTE: Segment end points are on the arc, which can lead to the arc diameter being smaller by up to
     // (2x) arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
     // is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
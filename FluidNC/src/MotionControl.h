@@ -29,7 +29,13 @@ void motors_to_cartesian(float* cartesian, float* motors, int n_axis);
 bool mc_linear(float* target, plan_line_data_t* pl_data, float* position);
 
 // Execute a linear motion in motor space.
-bool mc_move_motors(float* target, plan_line_data_t* pl_data);  // returns true if line was submitted to planner
+// If arc is given, the motion follows that arc. See plan_buffer_line().
+bool mc_move_motors(float* target, plan_line_data_t* pl_data, const plan_arc_t* arc = nullptr);  // returns true if line was submitted to planner
+
+// Execute a straight raster line in cartesian space, firing the laser at pixels[i] / 255 of the
+// spindle speed in pl_data along n_pixels equal pixels. Needs kinematics whose motor space is
+// cartesian, and at most plan_raster_capacity() pixels. Returns false if the line was not queued.
+bool mc_raster(float* target, plan_line_data_t* pl_data, float* position, const uint8_t* pixels, uint16_t n_pixels);
 
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_XXX defines circle plane in tool space, axis_linear is
@@ -26,6 +26,8 @@
 
 #include <cstdint>
 
+class Pin;
+
 namespace MotorDrivers {
     class MotorDriver : public Configuration::Configurable {
     public:
@@ -78,6 +80,14 @@ namespace MotorDrivers {
         // states of the step pins are unknown.
         virtual void unstep();
 
+        // stepPin() and dirPin() return the pins that a plain step/direction
+        // motor uses, so Axes can drive them directly instead of calling
+        // step(), unstep() and set_direction() on every ISR tick.  Motors that
+        // need their own code to step return nullptr.  Axes is the only writer
+        // of pins returned here once stepping has started.
+        virtual const Pin* stepPin() { return nullptr; }
+        virtual const Pin* dirPin() { return nullptr; }
+
         // this is used to configure and test motors. This would be used for Trinamic
         virtual void config_motor() {}
 
@@ -116,6 +116,14 @@ namespace MotorDrivers {
 
     void IRAM_ATTR StandardStepper::set_direction(bool dir) { _dir_pin.write(dir); }
 
+    // RMT pulses come from the RMT channel, so those steps must go through step()
+    const Pin* StandardStepper::stepPin() {
+        if (config->_stepping->_engine == Stepping::RMT && _rmt_chan_num != RMT_CHANNEL_MAX) {
+            return nullptr;
+        }
+        return &_step_pin;
+    }
+
     void IRAM_ATTR StandardStepper::set_disable(bool disable) { _disable_pin.synchronousWrite(disable); }
 
     // Configuration registration
@@ -22,6 +22,9 @@ namespace MotorDrivers {
         void unstep() override;
         void read_settings() override;
 
+        const Pin* stepPin() override;
+        const Pin* dirPin() override { return &_dir_pin; }
+
         void init_step_dir_pins();
 
     protected:
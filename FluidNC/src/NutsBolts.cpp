@@ -12,7 +12,27 @@
 #include <sstream>
 #include <iomanip>
 
-const int MAX_INT_DIGITS = 8;  // Maximum number of digits in int32 (and float)
+float decimal_to_float(uint32_t intval, int8_t exp) {
+    // Convert integer into floating point.
+    float fval;
+    fval = (float)intval;
+    // Apply decimal. Should perform no more than two floating point multiplications for the
+    // expected range of E0 to E-4.
+    if (fval != 0) {
+        while (exp <= -2) {
+            fval *= 0.01f;
+            exp += 2;
+        }
+        if (exp < 0) {
+            fval *= 0.1f;
+        } else if (exp > 0) {
+            do {
+                fval *= 10.0;
+            } while (--exp > 0);
+        }
+    }
+    return fval;
+}
 
 // Extracts a floating point value from a string. The following code is based loosely on
 // the avr-libc strtod() function by Michael Stumpf and Dmitry Xmelkov and many freely
@@ -66,24 +86,7 @@ bool read_float(const char* line, size_t* char_counter, float* float_ptr) {
         return false;
     }
 
-    // Convert integer into floating point.
-    float fval;
-    fval = (float)intval;
-    // Apply decimal. Should perform no more than two floating point multiplications for the
-    // expected range of E0 to E-4.
-    if (fval != 0) {
-        while (exp <= -2) {
-            fval *= 0.01f;
-            exp += 2;
-        }
-        if (exp < 0) {
-            fval *= 0.1f;
-        } else if (exp > 0) {
-            do {
-                fval *= 10.0;
-            } while (--exp > 0);
-        }
-    }
+    float fval = decimal_to_float(intval, exp);
     // Assign floating point value with correct sign.
     if (isnegative) {
         *float_ptr = -fval;
@@ -184,6 +187,23 @@ float limit_rate_by_axis_maximum(float* unit_vec) {
     return limit_value;
 }
 
+// Returns 0 if none of the moving axes has a jerk limit
+float limit_jerk_by_axis_maximum(float* unit_vec) {
+    float limit_value = SOME_LARGE_VALUE;
+    auto  n_axis      = config->_axes->_numberAxis;
+    for (size_t idx = 0; idx < n_axis; idx++) {
+        auto axisSetting = config->_axes->_axis[idx];
+        if (unit_vec[idx] != 0 && axisSetting->_maxJerk != 0) {
+            limit_value = MIN(limit_value, fabsf(axisSetting->_maxJerk / unit_vec[idx]));
+        }
+    }
+    if (limit_value == SOME_LARGE_VALUE) {
+        return 0.0f;
+    }
+    // mm/sec^3 to mm/min^3
+    return limit_value * secPerMinSq * 60.0f;
+}
+
 bool char_is_numeric(char value) {
     return value >= '0' && value <= '9';
 }
@@ -221,6 +241,43 @@ const char* to_hex(uint32_t n) {
     return hexstr;
 }
 
+int base64_decode(const char* in, uint8_t* out, size_t maxlen) {
+    uint32_t bits  = 0;
+    int      nbits = 0;
+    size_t   len   = 0;
+    for (; *in && *in != '='; in++) {
+        char     c = *in;
+        uint32_t value;
+        if (c >= 'A' && c <= 'Z') {
+            value = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            value = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            value = c - '0' + 52;
+        } else if (c == '+') {
+            value = 62;
+        } else if (c == '/') {
+            value = 63;
+        } else {
+            return -1;
+        }
+        bits = ((bits << 6) | value) & 0xffff;
+        nbits += 6;
+        if (nbits >= 8) {
+            nbits -= 8;
+            if (len == maxlen) {
+                return -1;
+            }
+            out[len++] = uint8_t(bits >> nbits);
+        }
+    }
+    // Only padding may follow the data
+    while (*in == '=') {
+        in++;
+    }
+    return *in ? -1 : int(len);
+}
+
 std::string formatBytes(uint64_t bytes) {
     if (bytes < 1024) {
         return std::to_string((uint16_t)bytes) + " B";
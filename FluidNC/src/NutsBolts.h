@@ -55,6 +55,11 @@ const float INCH_PER_MM = (0.0393701f);
 // a pointer to the result variable. Returns true when it succeeds
 bool read_float(const char* line, size_t* char_counter, float* float_ptr);
 
+// The parts of a number as read_float() collects them: the first MAX_INT_DIGITS digits
+// as an integer, and the power of ten to scale it by
+const int MAX_INT_DIGITS = 8;  // Maximum number of digits in int32 (and float)
+float     decimal_to_float(uint32_t intval, int8_t exp);
+
 // Blocking delay for very short time intervals
 void delay_us(int32_t microseconds);
 
@@ -79,9 +84,14 @@ void scale_vector(float* v, float scale, size_t n);
 float convert_delta_vector_to_unit_vector(float* vector);
 float limit_acceleration_by_axis_maximum(float* unit_vec);
 float limit_rate_by_axis_maximum(float* unit_vec);
+float limit_jerk_by_axis_maximum(float* unit_vec);
 
 const char* to_hex(uint32_t n);
 
+// Decodes base64 text into out.  Returns the number of bytes, or -1 if the text is
+// not base64 or does not fit in maxlen bytes.
+int base64_decode(const char* in, uint8_t* out, size_t maxlen);
+
 bool  char_is_numeric(char value);
 char* trim(char* value);
 
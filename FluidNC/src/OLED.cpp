@@ -243,7 +243,7 @@ void OLED::parse_status_report() {
         pos        = nextpos + 1;
         nextpos    = _report.find_first_of("|", pos);
         auto field = _report.substr(pos, nextpos - pos);
-        // MPos:, WPos:, Bf:, Ln:, FS:, Pn:, WCO:, Ov:, A:, SD: (ISRs:, Heap:)
+        // MPos:, WPos:, Bf:, Ln:, FS:, Pn:, WCO:, Ov:, A:, SD:, SDLn: (ISRs:, Heap:)
         auto colon = field.find_first_of(":");
         auto tag   = field.substr(0, colon);
         auto value = field.substr(colon + 1);
@@ -13,18 +13,56 @@
 
 #include <cstdlib>  // PSoc Required for labs
 #include <cmath>
+#include <new>  // std::nothrow
 
 static plan_block_t* block_buffer = nullptr;  // A ring buffer for motion instructions
-static uint8_t       block_buffer_tail;       // Index of the block to process now
-static uint8_t       block_buffer_head;       // Index of the next block to be pushed
-static uint8_t       next_buffer_head;        // Index of the next buffer head
-static uint8_t       block_buffer_planned;    // Index of the optimally planned block
+static uint16_t      block_buffer_tail;       // Index of the block to process now
+static uint16_t      block_buffer_head;       // Index of the next block to be pushed
+static uint16_t      next_buffer_head;        // Index of the next buffer head
+static uint16_t      block_buffer_planned;    // Index of the optimally planned block
+static bool          recalculate_all;         // Entry speeds behind block_buffer_planned are stale
+static uint32_t      block_count;             // Number of blocks queued, for throughput measurements
+
+// The raster pool holds the pixels of queued raster blocks. Blocks are executed in the order in
+// which they are queued, so the pool is a byte ring: plan_buffer_line() takes reservations at the
+// head and the stepper ISR releases everything before the block that it starts. Positions run
+// freely and are masked when used. A reservation never wraps; it skips to the start of the ring.
+static uint8_t*   raster_pool          = nullptr;
+static uint32_t   raster_pool_mask     = 0;
+static uint32_t   raster_head          = 0;  // End of the reservations taken by queued blocks
+static uint32_t   raster_reserved      = 0;  // End of the reservation from plan_raster_alloc()
+volatile uint32_t plan_raster_released = 0;
 
 void plan_init() {
     if (block_buffer) {
         delete[] block_buffer;
     }
-    block_buffer = new plan_block_t[config->_planner_blocks];
+    // Large planners are meant for boards with PSRAM, where big allocations come from PSRAM.
+    // The stepper ISR never touches the planner blocks, so slower memory is not a problem.
+    block_buffer = new (std::nothrow) plan_block_t[config->_planner_blocks];
+    if (!block_buffer) {
+        log_error("Cannot allocate " << config->_planner_blocks << " planner blocks, using 16");
+        config->_planner_blocks = 16;
+        block_buffer            = new plan_block_t[config->_planner_blocks];
+    }
+
+    if (raster_pool) {
+        delete[] raster_pool;
+        raster_pool      = nullptr;
+        raster_pool_mask = 0;
+    }
+    if (config->_rasterBufferBytes) {
+        uint32_t size = 1;
+        while (size < config->_rasterBufferBytes) {
+            size <<= 1;
+        }
+        raster_pool = new (std::nothrow) uint8_t[size];
+        if (raster_pool) {
+            raster_pool_mask = size - 1;
+        } else {
+            log_error("Cannot allocate the " << size << " byte raster buffer");
+        }
+    }
 }
 
 // Define planner variables
@@ -38,7 +76,7 @@ typedef struct {
 static planner_t pl;
 
 // Returns the index of the next block in the ring buffer. Also called by stepper segment buffer.
-static uint8_t plan_next_block_index(uint8_t block_index) {
+static uint16_t plan_next_block_index(uint16_t block_index) {
     block_index++;
     if (block_index == config->_planner_blocks) {
         block_index = 0;
@@ -47,7 +85,7 @@ static uint8_t plan_next_block_index(uint8_t block_index) {
 }
 
 // Returns the index of the previous block in the ring buffer
-static uint8_t plan_prev_block_index(uint8_t block_index) {
+static uint16_t plan_prev_block_index(uint16_t block_index) {
     if (block_index == 0) {
         block_index = config->_planner_blocks;
     }
@@ -119,10 +157,14 @@ static uint8_t plan_prev_block_index(uint8_t block_index) {
   to compute an optimal plan, so select carefully. The Arduino 328p memory is already maxed out, but future
   ARM versions should have enough memory and speed for look-ahead blocks numbering up to a hundred or more.
 
+  NOTE: Block indices are 16 bits, so with PSRAM the buffer can hold thousands of blocks. The reverse pass
+  stops at the first block whose entry speed does not change, so appending a block only costs as much as
+  the part of the plan that it actually affects, no matter how large the buffer is.
+
 */
 static void planner_recalculate() {
     // Initialize block index to the last block in the planner buffer.
-    uint8_t block_index = plan_prev_block_index(block_buffer_head);
+    uint16_t block_index = plan_prev_block_index(block_buffer_head);
     // Bail. Can't do anything with one only one plan-able block.
     if (block_index == block_buffer_planned) {
         return;
@@ -132,7 +174,8 @@ static void planner_recalculate() {
     // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
     float         entry_speed_sqr;
     plan_block_t* next;
-    plan_block_t* current = &block_buffer[block_index];
+    plan_block_t* current       = &block_buffer[block_index];
+    uint16_t      forward_start = block_buffer_planned;
     // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
     current->entry_speed_sqr = MIN(current->max_entry_speed_sqr, 2 * current->acceleration * current->millimeters);
     block_index              = plan_prev_block_index(block_index);
@@ -143,14 +186,16 @@ static void planner_recalculate() {
         }
     } else {  // Three or more plan-able blocks
         while (block_index != block_buffer_planned) {
-            next        = current;
-            current     = &block_buffer[block_index];
-            block_index = plan_prev_block_index(block_index);
+            next                   = current;
+            current                = &block_buffer[block_index];
+            uint16_t current_index = block_index;
+            block_index            = plan_prev_block_index(block_index);
             // Check if next block is the tail block(=planned block). If so, update current stepper parameters.
             if (block_index == block_buffer_tail) {
                 Stepper::update_plan_block_parameters();
             }
             // Compute maximum entry speed decelerating over the current block from its exit speed.
+            float old_entry_speed_sqr = current->entry_speed_sqr;
             if (current->entry_speed_sqr != current->max_entry_speed_sqr) {
                 entry_speed_sqr = next->entry_speed_sqr + 2 * current->acceleration * current->millimeters;
                 if (entry_speed_sqr < current->max_entry_speed_sqr) {
@@ -159,12 +204,27 @@ static void planner_recalculate() {
                     current->entry_speed_sqr = current->max_entry_speed_sqr;
                 }
             }
+            // Blocks after the planned pointer still hold the entry speeds of the previous reverse
+            // pass, since the forward pass moves the planned pointer to any block that it lowers.
+            // If this entry speed did not change, no block before it can change either, and the
+            // forward pass has nothing new to do before it.  This keeps the cost per new block
+            // proportional to the deceleration distance rather than to the planner size.
+            if (current->entry_speed_sqr == old_entry_speed_sqr && !recalculate_all) {
+                // The full pass would have reached the tail and updated the stepper.
+                if (block_index != block_buffer_planned && block_buffer_planned == block_buffer_tail) {
+                    Stepper::update_plan_block_parameters();
+                }
+                forward_start = current_index;
+                break;
+            }
         }
     }
+    recalculate_all = false;
+
     // Forward Pass: Forward plan the acceleration curve from the planned pointer onward.
     // Also scans for optimal plan breakpoints and appropriately updates the planned pointer.
-    next        = &block_buffer[block_buffer_planned];  // Begin at buffer planned pointer
-    block_index = plan_next_block_index(block_buffer_planned);
+    next        = &block_buffer[forward_start];  // Begin at buffer planned pointer or where the reverse pass stopped
+    block_index = plan_next_block_index(forward_start);
     while (block_index != block_buffer_head) {
         current = next;
         next    = &block_buffer[block_index];
@@ -200,12 +260,15 @@ void plan_reset_buffer() {
     block_buffer_head    = 0;  // Empty = tail
     next_buffer_head     = 1;  // plan_next_block_index(block_buffer_head)
     block_buffer_planned = 0;  // = block_buffer_tail;
+    recalculate_all      = false;
+    raster_head          = 0;
+    plan_raster_released = 0;
 }
 
 // Called from stepper pulse function when the block is complete
 void plan_discard_current_block() {
     if (block_buffer_head != block_buffer_tail) {  // Discard non-empty buffer.
-        uint8_t block_index = plan_next_block_index(block_buffer_tail);
+        uint16_t block_index = plan_next_block_index(block_buffer_tail);
         // Push block_buffer_planned pointer, if encountered.
         if (block_buffer_tail == block_buffer_planned) {
             block_buffer_planned = block_index;
@@ -228,7 +291,7 @@ plan_block_t* plan_get_current_block() {
 }
 
 float plan_get_exec_block_exit_speed_sqr() {
-    uint8_t block_index = plan_next_block_index(block_buffer_tail);
+    uint16_t block_index = plan_next_block_index(block_buffer_tail);
     if (block_index == block_buffer_head) {
         return 0.0f;
     }
@@ -240,6 +303,31 @@ uint8_t plan_check_full_buffer() {
     return block_buffer_tail == next_buffer_head;
 }
 
+uint32_t plan_raster_capacity() {
+    return raster_pool ? raster_pool_mask + 1 : 0;
+}
+
+uint8_t* plan_raster_alloc(uint16_t pixels) {
+    uint32_t size = plan_raster_capacity();
+    if (pixels == 0 || pixels > size) {
+        return nullptr;
+    }
+    if (block_buffer_head == block_buffer_tail && sys.state == State::Idle) {
+        // Nothing is queued or moving, so the last raster block is done with its pixels
+        plan_raster_released = raster_head;
+    }
+    uint32_t start  = raster_head;
+    uint32_t offset = start & raster_pool_mask;
+    if (offset + pixels > size) {
+        start += size - offset;
+    }
+    if (start + pixels - plan_raster_released > size) {
+        return nullptr;
+    }
+    raster_reserved = start + pixels;
+    return &raster_pool[start & raster_pool_mask];
+}
+
 // Computes and returns block nominal speed based on running condition and override values.
 // NOTE: All system motion commands, such as homing/parking, are not subject to overrides.
 float plan_compute_profile_nominal_speed(plan_block_t* block) {
@@ -277,7 +365,7 @@ static void plan_compute_profile_parameters(plan_block_t* block, float nominal_s
 
 // Re-calculates buffered motions profile parameters upon a motion-based override change.
 void plan_update_velocity_profile_parameters() {
-    uint8_t       block_index = block_buffer_tail;
+    uint16_t      block_index = block_buffer_tail;
     plan_block_t* block;
     float         nominal_speed;
     float         prev_nominal_speed = SOME_LARGE_VALUE;  // Set high for first block nominal speed calculation.
@@ -289,9 +377,43 @@ void plan_update_velocity_profile_parameters() {
         block_index        = plan_next_block_index(block_index);
     }
     pl.previous_nominal_speed = prev_nominal_speed;  // Update prev nominal speed for next incoming block.
+    recalculate_all           = true;                // Maximum entry speeds changed
+}
+
+// Computes the direction vectors of an arc block from the axis deltas in delta_vec. On return,
+// delta_vec holds the unit tangent at the start of the arc, and exit_vec the unit tangent at the
+// end. limit_vec is the direction used to apply the axis limits; it assumes that either plane axis
+// may carry all of the motion in the plane, which is the worst case along the arc. Returns the
+// path length of the arc.
+static float plan_arc_vectors(const plan_arc_t* arc, float* delta_vec, float* limit_vec, float* exit_vec) {
+    auto  n_axis = config->_axes->_numberAxis;
+    float planar = arc->radius * fabsf(arc->angular_travel);
+
+    delta_vec[arc->axis_0] = 0.0f;
+    delta_vec[arc->axis_1] = 0.0f;
+    float linear           = vector_length(delta_vec, n_axis);
+    float length           = sqrtf(planar * planar + linear * linear);
+    if (length == 0.0f) {
+        return 0.0f;
+    }
+    scale_vector(delta_vec, 1.0f / length, n_axis);
+    copyAxes(limit_vec, delta_vec);
+    copyAxes(exit_vec, delta_vec);
+
+    float planar_unit = planar / length;
+    float direction   = arc->angular_travel < 0.0f ? -planar_unit : planar_unit;
+    float end_angle   = arc->start_angle + arc->angular_travel;
+
+    limit_vec[arc->axis_0] = planar_unit;
+    limit_vec[arc->axis_1] = planar_unit;
+    delta_vec[arc->axis_0] = -sinf(arc->start_angle) * direction;
+    delta_vec[arc->axis_1] = cosf(arc->start_angle) * direction;
+    exit_vec[arc->axis_0]  = -sinf(end_angle) * direction;
+    exit_vec[arc->axis_1]  = cosf(end_angle) * direction;
+    return length;
 }
 
-bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
+bool plan_buffer_line(float* target, plan_line_data_t* pl_data, const plan_arc_t* arc) {
     // Prepare and initialize new block. Copy relevant pl_data for block execution.
     plan_block_t* block = &block_buffer[block_buffer_head];
     memset(block, 0, sizeof(plan_block_t));  // Zero all block values.
@@ -301,6 +423,13 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     block->spindle_speed = pl_data->spindle_speed;
     block->line_number   = pl_data->line_number;
     block->is_jog        = pl_data->is_jog;
+    // Pixels before the mark belong to blocks that are queued ahead of this one. System motions
+    // do not run in queue order, so they never release anything.
+    block->raster_mark = block->motion.systemMotion ? plan_raster_released : raster_head;
+    if (pl_data->raster && !arc && !block->motion.systemMotion) {
+        block->raster        = pl_data->raster;
+        block->raster_pixels = pl_data->raster_pixels;
+    }
 
     // Compute and store initial move distance data.
     int32_t target_steps[MAX_N_AXIS], position_steps[MAX_N_AXIS];
@@ -324,7 +453,8 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         }
     }
     // Bail if this is a zero-length block. Highly unlikely to occur.
-    if (block->step_event_count == 0) {
+    // NOTE: A full circle returns to its start, so arcs are checked by their path length instead.
+    if (block->step_event_count == 0 && !arc) {
         return false;
     }
 
@@ -332,9 +462,34 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
     // down such that no individual axes maximum values are exceeded with respect to the line direction.
     // NOTE: This calculation assumes all axes are orthogonal (Cartesian) and works with ABC-axes,
     // if they are also orthogonal/independent. Operates on the absolute value of the unit vector.
-    block->millimeters  = convert_delta_vector_to_unit_vector(unit_vec);
-    block->acceleration = limit_acceleration_by_axis_maximum(unit_vec);
-    block->rapid_rate   = limit_rate_by_axis_maximum(unit_vec);
+    float  arc_limit_vec[MAX_N_AXIS], arc_exit_vec[MAX_N_AXIS];
+    float* limit_vec = unit_vec;  // Direction that the axis limits apply to
+    float* exit_vec  = unit_vec;  // Direction at the end of the block, for the next junction
+    if (arc) {
+        block->millimeters = plan_arc_vectors(arc, unit_vec, arc_limit_vec, arc_exit_vec);
+        if (block->millimeters == 0.0f) {
+            return false;
+        }
+        block->is_arc     = true;
+        block->arc        = *arc;
+        block->arc.length = block->millimeters;
+        limit_vec         = arc_limit_vec;
+        exit_vec          = arc_exit_vec;
+    } else {
+        block->millimeters = convert_delta_vector_to_unit_vector(unit_vec);
+    }
+    block->acceleration = limit_acceleration_by_axis_maximum(limit_vec);
+    block->rapid_rate   = limit_rate_by_axis_maximum(limit_vec);
+    if (arc) {
+        // Keep the centripetal acceleration of the motion in the plane within the limits of the
+        // plane axes. The stepper follows the arc itself, so the planner junctions do not do it.
+        float plane_vec[MAX_N_AXIS] = { 0.0f };
+        plane_vec[arc->axis_0]      = 1.0f;
+        plane_vec[arc->axis_1]      = 1.0f;
+        float planar_unit           = arc->radius * fabsf(arc->angular_travel) / block->millimeters;
+        float max_rate              = sqrtf(limit_acceleration_by_axis_maximum(plane_vec) * arc->radius) / planar_unit;
+        block->rapid_rate           = MIN(block->rapid_rate, max_rate);
+    }
     // Store programmed rate.
     if (block->motion.rapidMotion) {
         block->programmed_rate = block->rapid_rate;
@@ -344,6 +499,21 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
             block->programmed_rate *= block->millimeters;
         }
     }
+    // With a jerk limit, the stepper runs each acceleration ramp as an S-curve. The planned
+    // acceleration is the average over a ramp, and the S-curve peaks at SCURVE_PEAK_FACTOR times
+    // that, so scale it down to keep the peak within the axis maximum. The peak jerk of a ramp is
+    // SCURVE_JERK_FACTOR times acceleration^2 / delta-speed, so also cap the acceleration such
+    // that a ramp from rest to the nominal rate stays within the jerk limit. Shorter ramps are
+    // stretched by the stepper.
+    block->jerk = limit_jerk_by_axis_maximum(limit_vec);
+    if (block->jerk > 0) {
+        block->acceleration /= SCURVE_PEAK_FACTOR;
+        float nominal_rate      = MIN(block->programmed_rate, block->rapid_rate);
+        float jerk_acceleration = sqrtf(block->jerk * nominal_rate / SCURVE_JERK_FACTOR);
+        if (jerk_acceleration < block->acceleration) {
+            block->acceleration = jerk_acceleration;
+        }
+    }
     // TODO: Need to check this method handling zero junction speeds when starting from rest.
     if ((block_buffer_head == block_buffer_tail) || (block->motion.systemMotion)) {
         // Initialize block entry speed as zero. Assume it will be starting from rest. Planner will correct this later.
@@ -402,11 +572,15 @@ bool plan_buffer_line(float* target, plan_line_data_t* pl_data) {
         plan_compute_profile_parameters(block, nominal_speed, pl.previous_nominal_speed);
         pl.previous_nominal_speed = nominal_speed;
         // Update previous path unit_vector and planner position.
-        copyAxes(pl.previous_unit_vec, unit_vec);
+        copyAxes(pl.previous_unit_vec, exit_vec);
         copyAxes(pl.position, target_steps);
         // New block is all set. Update buffer head and next buffer head indices.
+        if (block->raster) {
+            raster_head = raster_reserved;
+        }
         block_buffer_head = next_buffer_head;
         next_buffer_head  = plan_next_block_index(block_buffer_head);
+        ++block_count;
         // Finish up by recalculating the plan with the new block.
         planner_recalculate();
     }
@@ -424,7 +598,7 @@ void plan_sync_position() {
 
 // Returns the number of available blocks are in the planner buffer.
 // Called from report_realtime_status
-uint8_t plan_get_block_buffer_available() {
+uint16_t plan_get_block_buffer_available() {
     if (block_buffer_head >= block_buffer_tail) {
         return (config->_planner_blocks - 1) - (block_buffer_head - block_buffer_tail);
     } else {
@@ -432,11 +606,17 @@ uint8_t plan_get_block_buffer_available() {
     }
 }
 
+// Returns the number of blocks that have been queued by plan_buffer_line()
+uint32_t plan_get_block_count() {
+    return block_count;
+}
+
 // Re-initialize buffer plan with a partially completed block, assumed to exist at the buffer tail.
 // Called after a steppers have come to a complete stop for a feed hold and the cycle is stopped.
 void plan_cycle_reinitialize() {
     // Re-plan from a complete stop. Reset planner entry speeds and buffer planned pointer.
     Stepper::update_plan_block_parameters();
     block_buffer_planned = block_buffer_tail;
+    recalculate_all      = true;
     planner_recalculate();
 }
@@ -15,6 +15,15 @@
 
 #include <cstdint>
 
+// Peak jerk of the S-curve ramps used with jerk limiting, in units of acceleration^2 / delta-speed.
+// The ramp speed follows the quintic smoothstep 6u^5 - 15u^4 + 10u^3, whose second derivative
+// peaks at 10 / sqrt(3).
+const float SCURVE_JERK_FACTOR = 5.7735f;
+
+// Peak acceleration of an S-curve ramp relative to the average acceleration of the same ramp.
+// The first derivative of the quintic smoothstep peaks at 15/8.
+const float SCURVE_PEAK_FACTOR = 1.875f;
+
 // Define planner data condition flags. Used to denote running conditions of a block.
 struct PlMotion {
     uint8_t rapidMotion : 1;
@@ -23,6 +32,17 @@ struct PlMotion {
     uint8_t inverseTime : 1;     // Interprets feed rate value as inverse time when set.
 };
 
+// Circular or helical path of a planner block. The arc lies in the plane of axis_0 and axis_1 and
+// starts at the position where the block starts. The other axes move linearly along the arc.
+struct plan_arc_t {
+    uint8_t axis_0;          // First axis of the arc plane
+    uint8_t axis_1;          // Second axis of the arc plane
+    float   radius;          // (mm)
+    float   start_angle;     // Angle of the start position about the arc center (radians)
+    float   angular_travel;  // Angle swept, counterclockwise positive (radians)
+    float   length;          // Path length (mm). Computed by the planner.
+};
+
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
 // are as specified in the source g-code.
 struct plan_block_t {
@@ -45,6 +65,7 @@ struct plan_block_t {
     float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
     //   neighboring nominal speeds with overrides in (mm/min)^2
     float acceleration;  // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
+    float jerk;          // Axis-limit adjusted jerk in (mm/min^3). Zero for trapezoidal ramps.
     float millimeters;   // The remaining distance for this block to be executed in (mm).
     // NOTE: This value may be altered by stepper algorithm during execution.
 
@@ -57,6 +78,15 @@ struct plan_block_t {
     SpindleSpeed spindle_speed;  // Block spindle speed. Copied from pl_line_data.
 
     bool is_jog;
+
+    bool       is_arc;  // The block follows the arc rather than a straight line
+    plan_arc_t arc;
+
+    // Raster blocks divide their straight path into raster_pixels equal pixels. The laser fires each
+    // pixel at raster[i] / 255 of the spindle speed of the block.
+    const uint8_t* raster;         // Per-pixel power in the raster pool, or nullptr
+    uint16_t       raster_pixels;  // Number of pixels
+    uint32_t       raster_mark;    // Raster pool position when the block was queued
 };
 
 // Planner data prototype. Must be used when passing new motions to the planner.
@@ -68,6 +98,9 @@ struct plan_line_data_t {
     CoolantState coolant;        // Coolant state
     int32_t      line_number;    // Desired line number to report when executing.
     bool         is_jog;         // true if this was generated due to a jog command
+
+    const uint8_t* raster        = nullptr;  // Per-pixel power from plan_raster_alloc(), for a raster line
+    uint16_t       raster_pixels = 0;
 };
 
 void plan_init();
@@ -79,8 +112,9 @@ void plan_reset_buffer();  // Reset buffer only.
 // Add a new linear movement to the buffer. target[MAX_N_AXIS] is the signed, absolute target position
 // in millimeters. Feed rate specifies the speed of the motion. If feed rate is inverted, the feed
 // rate is taken to mean "frequency" and would complete the operation in 1/feed_rate minutes.
-// Returns true on success.
-bool plan_buffer_line(float* target, plan_line_data_t* pl_data);
+// If arc is given, the block follows that circular or helical path to the target, and the steps of
+// each segment are computed from the arc. Returns true on success.
+bool plan_buffer_line(float* target, plan_line_data_t* pl_data, const plan_arc_t* arc = nullptr);
 
 // Called when the current block is no longer needed. Discards the block and makes the memory
 // availible for new blocks.
@@ -93,7 +127,7 @@ plan_block_t* plan_get_system_motion_block();
 plan_block_t* plan_get_current_block();
 
 // Increment block index with wrap-around
-static uint8_t plan_next_block_index(uint8_t block_index);
+static uint16_t plan_next_block_index(uint16_t block_index);
 
 // Called by step segment buffer when computing executing block velocity profile.
 float plan_get_exec_block_exit_speed_sqr();
@@ -111,9 +145,24 @@ void plan_sync_position();
 void plan_cycle_reinitialize();
 
 // Returns the number of available blocks are in the planner buffer.
-uint8_t plan_get_block_buffer_available();
+uint16_t plan_get_block_buffer_available();
+
+// Returns the number of blocks that have been queued since power-up. Used for throughput measurements.
+uint32_t plan_get_block_count();
 
 // Returns the status of the block ring buffer. True, if buffer is full.
 uint8_t plan_check_full_buffer();
 
+// Reserves room for the pixels of a raster line in the raster pool. The reservation is taken by the
+// next plan_buffer_line() whose pl_data points to it. Returns nullptr if the pool cannot hold that
+// many pixels right now; they become available as queued raster blocks start executing.
+uint8_t* plan_raster_alloc(uint16_t pixels);
+
+// Largest number of pixels that a raster line may have
+uint32_t plan_raster_capacity();
+
+// Raster pool data before this position is no longer needed. Advanced by the stepper ISR when it
+// starts a block, to the raster_mark of that block.
+extern volatile uint32_t plan_raster_released;
+
 void plan_get_planner_mpos(float* target);
@@ -22,6 +22,8 @@
 #include "FileStream.h"           // FileStream()
 #include "xmodem.h"               // xmodemReceive(), xmodemTransmit()
 #include "StartupLog.h"           // startupLog
+#include "StepperStats.h"         // StepperStats::report()
+#include "TaskStats.h"            // TaskStats::report()
 #include "Driver/fluidnc_gpio.h"  // gpio_dump()
 
 #include "FluidPath.h"
@@ -492,6 +494,36 @@ static Error doJog(const char* value, WebUI::AuthenticationLevel auth_level, Cha
     return gc_execute_line(jogLine);
 }
 
+// $Raster=<words>:<pixels> is a G1 move whose laser power changes along the way.
+// <words> are the axis, F and S words of the move and <pixels> is base64 text with
+// one byte per pixel, 0 to 255 of S.  The pixels are spaced evenly from the current
+// position to the target.  A scanline costs about 4/3 of a character per pixel
+// instead of a G1 X..S.. line per pixel, and the parser runs once per scanline.
+static Error rasterLine(const char* value, WebUI::AuthenticationLevel auth_level, Channel& out) {
+    if (sys.state == State::Alarm || sys.state == State::ConfigAlarm || sys.state == State::Jog) {
+        return Error::SystemGcLock;
+    }
+    const char* pixels;
+    if (!value || (pixels = strchr(value, ':')) == nullptr) {
+        return Error::InvalidStatement;
+    }
+    char   line[LINE_BUFFER_SIZE];
+    size_t words = pixels - value;
+    if (words + 3 > sizeof(line)) {
+        return Error::LineLengthExceeded;
+    }
+    strcpy(line, "G1");
+    memcpy(line + 2, value, words);
+    line[words + 2] = '\0';
+
+    uint8_t power[Channel::maxLine];
+    int     n_pixels = base64_decode(pixels + 1, power, sizeof(power));
+    if (n_pixels <= 0) {
+        return Error::BadNumberFormat;
+    }
+    return gc_execute_raster(line, power, n_pixels);
+}
+
 static const char* alarmString(ExecAlarm alarmNumber) {
     auto it = AlarmNames.find(alarmNumber);
     return it == AlarmNames.end() ? NULL : it->second;
@@ -702,6 +734,8 @@ static Error fakeLaserMode(const char* value, WebUI::AuthenticationLevel auth_le
 
 static Error showChannelInfo(const char* value, WebUI::AuthenticationLevel auth_level, Channel& out) {
     allChannels.listChannels(out);
+    log_to(out, "[OUTPUT:dropped:", output_dropped_lines.load());
+    log_to(out, "[LOG:", "arena_full:" << log_arena_full.load() << " oversize:" << log_oversize.load());
     return Error::Ok;
 }
 
@@ -748,6 +782,90 @@ static Error setReportInterval(const char* value, WebUI::AuthenticationLevel aut
     return Error::Ok;
 }
 
+static Error compactReports(const char* value, WebUI::AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        if (!strcasecmp(value, "on")) {
+            out.setCompactReports(true);
+        } else if (!strcasecmp(value, "off")) {
+            out.setCompactReports(false);
+        } else {
+            return Error::InvalidValue;
+        }
+    }
+    log_to(out, "[REPORT:", (out.compactReports() ? "compact" : "full") << " interval:" << out.getReportInterval());
+    return Error::Ok;
+}
+
+static Error streamMode(const char* value, WebUI::AuthenticationLevel auth_level, Channel& out) {
+    if (value) {
+        if (!strcasecmp(value, "on")) {
+            if (out.startStreaming() <= 0) {
+                return Error::InvalidStatement;
+            }
+        } else if (!strcasecmp(value, "off")) {
+            out.stopStreaming();
+        } else {
+            return Error::InvalidValue;
+        }
+    }
+    if (out.isStreaming()) {
+        log_to(out, "[STREAM:", "on window:" << out.streamWindow());
+    } else {
+        log_to(out, "[STREAM:off]");
+    }
+    return Error::Ok;
+}
+
+static Error stepperStats(const char* value, WebUI::AuthenticationLevel auth_level, Channel& out) {
+    if (!value) {
+        StepperStats::report(out);
+        return Error::Ok;
+    }
+    if (!strcasecmp(value, "reset")) {
+        StepperStats::reset();
+    } else if (!strcasecmp(value, "status")) {
+        StepperStats::_inStatus = true;
+    } else if (!strcasecmp(value, "nostatus")) {
+        StepperStats::_inStatus = false;
+    } else {
+        return Error::InvalidValue;
+    }
+    return Error::Ok;
+}
+
+// $Sys/Tasks reports on the time since the previous report.  $Sys/Tasks=<ms>
+// measures over the next <ms> instead, up to 10 seconds.  That holds up the main
+// loop, so it is only allowed when nothing is moving; during a job, send
+// $Sys/Tasks twice instead.
+static Error showTasks(const char* value, WebUI::AuthenticationLevel auth_level, Channel& out) {
+    uint32_t windowMs = 0;
+    if (value) {
+        char* end;
+        windowMs = strtoul(value, &end, 10);
+        if (*end || windowMs == 0 || windowMs > 10000) {
+            return Error::InvalidValue;
+        }
+        if (sys.state != State::Idle && sys.state != State::Alarm) {
+            return Error::IdleError;
+        }
+    }
+    TaskStats::report(out, windowMs);
+    return Error::Ok;
+}
+
+static Error gcodeStats(const char* value, WebUI::AuthenticationLevel auth_level, Channel& out) {
+    if (!value) {
+        log_to(out, "[GCODE:", "fast_path:" << gc_fast_path_lines << " full_path:" << gc_full_path_lines);
+        return Error::Ok;
+    }
+    if (!strcasecmp(value, "reset")) {
+        gc_fast_path_lines = 0;
+        gc_full_path_lines = 0;
+        return Error::Ok;
+    }
+    return Error::InvalidValue;
+}
+
 // Commands use the same syntax as Settings, but instead of setting or
 // displaying a persistent value, a command causes some action to occur.
 // That action could be anything, from displaying a run-time parameter
@@ -763,6 +881,7 @@ void make_user_commands() {
     new UserCommand("", "Help", show_help, anyState);
     new UserCommand("T", "State", showState, anyState);
     new UserCommand("J", "Jog", doJog, notIdleOrJog);
+    new UserCommand("RA", "Raster", rasterLine, anyState);
 
     new UserCommand("$", "GrblSettings/List", report_normal_settings, cycleOrHold);
     new UserCommand("L", "GrblNames/List", list_grbl_names, cycleOrHold);
@@ -773,6 +892,7 @@ void make_user_commands() {
     new UserCommand("A", "Alarms/List", listAlarms, anyState);
     new UserCommand("E", "Errors/List", listErrors, anyState);
     new UserCommand("G", "GCode/Modes", report_gcode, anyState);
+    new UserCommand("GS", "GCode/Stats", gcodeStats, anyState);
     new UserCommand("C", "GCode/Check", toggle_check_mode, anyState);
     new UserCommand("X", "Alarm/Disable", disable_alarm_lock, anyState);
     new UserCommand("NVX", "Settings/Erase", Setting::eraseNVS, notIdleOrAlarm, WA);
@@ -800,6 +920,10 @@ void make_user_commands() {
     new UserCommand("SS", "Startup/Show", showStartupLog, anyState);
 
     new UserCommand("RI", "Report/Interval", setReportInterval, anyState);
+    new UserCommand("RC", "Report/Compact", compactReports, anyState);
+    new UserCommand("ST", "Stream", streamMode, anyState);
+    new UserCommand("SST", "Stepper/Stats", stepperStats, anyState);
+    new UserCommand("TK", "Sys/Tasks", showTasks, anyState);
 
     new UserCommand("30", "FakeMaxSpindleSpeed", fakeMaxSpindleSpeed, notIdleOrAlarm);
     new UserCommand("32", "FakeLaserMode", fakeLaserMode, notIdleOrAlarm);
@@ -18,6 +18,12 @@
 #include "MotionControl.h"  // PARKING_MOTION_LINE_NUMBER
 #include "Settings.h"       // settings_execute_startup
 #include "Machine/LimitPin.h"
+#include "Serial.h"     // allChannels
+#include "TaskStats.h"  // TaskStats::wait()
+
+#include <atomic>
+#include <mutex>
+#include <cstring>
 
 volatile ExecAlarm rtAlarm;  // Global realtime executor bitflag variable for setting various alarms.
 
@@ -87,125 +93,329 @@ static void request_safety_door() {
 
 TaskHandle_t outputTask = nullptr;
 
-xQueueHandle message_queue;
-
-struct LogMessage {
-    Channel* channel;
-    void*    line;
-    bool     isString;
+// Output is collected in a ring buffer per channel, so the output task can send
+// everything that is pending for a channel with one write, and a channel that is
+// slow to drain does not hold up messages for the others.  Ring 0 is reserved for
+// allChannels.  A ring is claimed by a channel when it has something to send, and
+// released once the output task has emptied it.
+struct OutputRing {
+    static const size_t size = 1024;
+
+    std::atomic<Channel*> channel { nullptr };
+    std::atomic<size_t>   head { 0 };  // Advanced by send_line(), under outputMutex
+    std::atomic<size_t>   tail { 0 };  // Advanced by the output task
+    bool                  streaming = false;  // A line longer than the ring is going through it, under outputMutex
+    std::atomic<bool>     flushing { false };  // The output task is writing to channel; see output_forget()
+    char                  data[size];
+
+    size_t used() { return head - tail; }
+    size_t space() { return size - used(); }
 };
 
+static const int  nOutputRings = 6;
+static OutputRing outputRings[nOutputRings];
+static std::mutex outputMutex;
+
+// How long send_line() waits for room in a full ring before it drops the line
+static const TickType_t outputWaitTicks = 50;
+
+std::atomic<uint32_t> output_dropped_lines { 0 };
+
 void drain_messages() {
-    while (uxQueueMessagesWaiting(message_queue)) {
-        vTaskDelay(1);  // Let the output task finish sending data
+    for (auto& ring : outputRings) {
+        while (ring.used()) {
+            vTaskDelay(1);  // Let the output task finish sending data
+        }
     }
 }
 
-// This overload is used primarily with fixed string
-// values.  It sends a pointer to the string whose
-// memory does not need to be reclaimed later.
-// This is the most efficient form, but it only works
-// with fixed messages.
-void send_line(Channel& channel, const char* line) {
-    if (outputTask) {
-        LogMessage msg { &channel, (void*)line, false };
-        while (!xQueueSend(message_queue, &msg, 10)) {}
-    } else {
-        channel.println(line);
+// Returns the ring for channel, claiming a free one if necessary, or nullptr if
+// they are all in use.  Called with outputMutex held.
+static OutputRing* output_ring(Channel& channel) {
+    if (&channel == &allChannels) {
+        outputRings[0].channel = &allChannels;
+        return &outputRings[0];
+    }
+    OutputRing* free = nullptr;
+    for (int i = 1; i < nOutputRings; i++) {
+        auto& ring = outputRings[i];
+        if (ring.channel == &channel) {
+            return &ring;
+        }
+        if (!free && ring.channel == nullptr) {
+            free = &ring;
+        }
+    }
+    if (free) {
+        free->channel = &channel;
+    }
+    return free;
+}
+
+// Appends n bytes to the ring.  Called with outputMutex held.
+static void output_put(OutputRing& ring, const char* data, size_t n) {
+    size_t head = ring.head;
+    for (size_t i = 0; i < n; i++) {
+        ring.data[(head + i) % OutputRing::size] = data[i];
     }
+    ring.head = head + n;
 }
 
-// This overload is used primarily with log_*() where
-// a std::string is dynamically allocated with "new",
-// and then extended to construct the message.  Its
-// pointer is sent to the output task, which sends
-// the message to the output channel and then "delete"s
-// the pointer to reclaim the memory.
-// This form has intermediate efficiency, as the string
-// is allocated once and freed once.
-void send_line(Channel& channel, const std::string* line) {
+// Copies the line and its line ending into the ring for channel.  When the ring
+// has room, which is the usual case, this does not wait for the channel at all.
+// Otherwise it polls for room without holding outputMutex, and drops the line and
+// counts it when the ring stays full for outputWaitTicks.  A line that is longer
+// than the ring is streamed through it in pieces, with the ring marked so that no
+// other line can get in between.  It keeps room for its line ending, so a line
+// that is cut short by a stalled channel still ends with one.
+static void output_line(Channel& channel, const char* line) {
+    static const char eol[] = "\r\n";
+
+    size_t len      = strlen(line);
+    bool   longLine = len + 2 > OutputRing::size;
+
+    TickType_t deadline = xTaskGetTickCount() + outputWaitTicks;
+    size_t     sent     = 0;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+
+            OutputRing* ring = output_ring(channel);
+            size_t      room = (ring && (sent || !ring->streaming)) ? ring->space() : 0;
+            if (!longLine && room >= len + 2) {
+                output_put(*ring, line, len);
+                output_put(*ring, eol, 2);
+                TaskStats::notify(TaskStats::Output);
+                return;
+            }
+            if (longLine && room > 2) {
+                size_t n = std::min(room - 2, len - sent);
+                output_put(*ring, line + sent, n);
+                sent += n;
+                ring->streaming = sent < len;
+                if (!ring->streaming) {
+                    output_put(*ring, eol, 2);
+                }
+                TaskStats::notify(TaskStats::Output);
+                if (!ring->streaming) {
+                    return;
+                }
+                deadline = xTaskGetTickCount() + outputWaitTicks;
+            } else if (int32_t(xTaskGetTickCount() - deadline) >= 0) {
+                if (sent) {
+                    output_put(*ring, eol, 2);
+                    ring->streaming = false;
+                    TaskStats::notify(TaskStats::Output);
+                }
+                ++output_dropped_lines;
+                return;
+            }
+        }
+        vTaskDelay(1);
+    }
+}
+
+// This overload is used primarily with fixed string
+// values, and with log_*() messages, which LogStream
+// builds in its own arena.
+void send_line(Channel& channel, const char* line) {
     if (outputTask) {
-        LogMessage msg { &channel, (void*)line, true };
-        while (!xQueueSend(message_queue, &msg, 10)) {}
+        output_line(channel, line);
     } else {
-        channel.println(line->c_str());
-        delete line;
+        channel.println(line);
     }
 }
 
 // This overload is used for many miscellaneous messages
 // where the std::string is allocated in a code block and
-// then extended with various information.  This send_line()
-// copies that string to a newly allocated one and sends that
-// via the std::string* version of send_line().  The original
-// string is freed by the caller sometime after send_line()
-// returns, while the new string is freed by the output task
-// after the message is forwared to the output channel.
-// This is the least efficient form, requiring two strings
-// to be allocated and freed, with an intermediate copy.
-// It is used only rarely.
+// then extended with various information.  The string
+// is freed by the caller sometime after send_line()
+// returns.
 void send_line(Channel& channel, const std::string& line) {
     if (outputTask) {
-        send_line(channel, new std::string(line));
+        output_line(channel, line.c_str());
     } else {
         channel.println(line.c_str());
     }
 }
 
+// Discards any output that is still pending for a channel that is going away.
+// Once it returns, the output task no longer uses the channel, so it can be
+// deleted.  output_flush() sets flushing before it reads the channel, so either
+// it sees the channel cleared here, or this sees it flushing and waits.
+void output_forget(Channel& channel) {
+    OutputRing* forgotten[nOutputRings];
+    int         n = 0;
+    {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        for (int i = 1; i < nOutputRings; i++) {
+            auto& ring = outputRings[i];
+            if (ring.channel == &channel) {
+                ring.channel   = nullptr;
+                ring.tail      = ring.head.load();
+                forgotten[n++] = &ring;
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        while (forgotten[i]->flushing) {
+            vTaskDelay(1);
+        }
+    }
+}
+
+// Sends what is pending in the ring with at most two writes, one if the data
+// does not wrap around the end of the buffer.  Returns true if anything was sent.
+static bool output_flush(OutputRing& ring, size_t head) {
+    size_t tail = ring.tail;
+    if (head == tail) {
+        return false;
+    }
+    ring.flushing    = true;
+    Channel* channel = ring.channel;
+    if (channel) {
+        size_t start = tail % OutputRing::size;
+        size_t n     = std::min(head - tail, OutputRing::size - start);
+        channel->write(reinterpret_cast<const uint8_t*>(ring.data + start), n);
+        if (n < head - tail) {
+            channel->write(reinterpret_cast<const uint8_t*>(ring.data), head - tail - n);
+        }
+    }
+    ring.flushing = false;
+    ring.tail     = head;
+    return true;
+}
+
 void output_loop(void* unused) {
+    TaskStats::start(TaskStats::Output);
     while (true) {
-        LogMessage message;
-        if (xQueueReceive(message_queue, &message, 0)) {
-            if (message.isString) {
-                std::string* s = static_cast<std::string*>(message.line);
-                message.channel->println(s->c_str());
-                delete s;
-            } else {
-                const char* cp = static_cast<const char*>(message.line);
-                message.channel->println(cp);
+        // A message for one channel can follow a broadcast that it depends on,
+        // like an ok after the [MSG:] lines of the command.  Taking the heads of
+        // the channel rings before the one for allChannels, and sending that one
+        // first, keeps every such broadcast ahead of what came after it.
+        size_t heads[nOutputRings];
+        for (int i = nOutputRings - 1; i >= 0; i--) {
+            heads[i] = outputRings[i].head;
+        }
+        bool sent = false;
+        for (int i = 0; i < nOutputRings; i++) {
+            sent |= output_flush(outputRings[i], heads[i]);
+        }
+
+        // Release the rings that are empty, unless a sender has just added to one
+        for (int i = 1; i < nOutputRings; i++) {
+            auto& ring = outputRings[i];
+            if (ring.channel && !ring.used()) {
+                std::unique_lock<std::mutex> lock(outputMutex, std::try_to_lock);
+                if (lock.owns_lock() && !ring.used() && !ring.streaming) {
+                    ring.channel = nullptr;
+                }
             }
         }
-        vTaskDelay(0);
+        if (!sent) {
+            // output_line() wakes us as soon as it adds to a ring.  The timeout
+            // is for a ring that could not be released just now.
+            TaskStats::wait(TaskStats::Output, 10);
+        }
     }
 }
 
-Channel* activeChannel = nullptr;  // Channel associated with the input line
+// Lines travel from the polling task to the main loop through this queue, so the
+// poller can go on reading and splitting lines while the main loop is busy in the
+// parser or waiting for room in the planner.  There is one writer, the poller, and
+// one reader, the main loop, so head and tail are enough to keep them apart.  A
+// slot is released only after its line has been executed and acked, so a line in
+// the queue keeps its channel alive; see protocol_has_lines_from().
+struct InputLine {
+    Channel*                   channel;
+    WebUI::AuthenticationLevel auth_level;
+    char                       line[Channel::maxLine];
+};
 
-TaskHandle_t pollingTask = nullptr;
+static const uint32_t        nInputLines = 8;
+static InputLine             inputLines[nInputLines];
+static std::atomic<uint32_t> inputHead { 0 };  // Advanced by the poller when it adds a line
+static std::atomic<uint32_t> inputTail { 0 };  // Advanced by the main loop when a line is done
+
+bool protocol_has_lines_from(Channel* channel) {
+    for (uint32_t i = inputTail; i != inputHead; i++) {
+        if (inputLines[i % nInputLines].channel == channel) {
+            return true;
+        }
+    }
+    return false;
+}
 
-char activeLine[Channel::maxLine];
+TaskHandle_t pollingTask = nullptr;
 
 bool pollingPaused = false;
+
+// The main loop stops the poller for a reset by asking it to park, rather than
+// suspending it, because the poller may be holding outputMutex for a report and
+// the reset messages would then wait for it forever.
+static std::atomic<bool> pollingStop { false };    // Set by stop_polling(), cleared by start_polling()
+static std::atomic<bool> pollingParked { false };  // Set by the poller while it is parked
+
 void polling_loop(void* unused) {
-    // Poll the input sources waiting for a complete line to arrive
-    for (; true; /*feedLoopWDT(), */ vTaskDelay(0)) {
+    TaskStats::start(TaskStats::Poller);
+
+    // Poll the input sources waiting for a complete line to arrive.  When a pass
+    // finds nothing, the poller sleeps until the next tick, or until it is woken
+    // by the main loop taking a line or by a channel that has received data.
+    for (; true; /*feedLoopWDT(), */) {
+        if (pollingStop) {
+            pollingParked = true;
+            while (pollingStop) {
+                TaskStats::wait(TaskStats::Poller, 10);
+            }
+            pollingParked = false;
+            continue;
+        }
+
         // Polling is paused when xmodem is using a channel for binary upload
         if (pollingPaused) {
             vTaskDelay(100);
             continue;
         }
-        if (activeChannel) {
-            // Poll for realtime characters when waiting for the primary loop
-            // (in another thread) to pick up the line.
+        uint32_t head = inputHead;
+        if (head - inputTail == nInputLines) {
+            // Poll for realtime characters when the queue is full, waiting for
+            // the primary loop (in another thread) to take the lines.
             pollChannels();
+            TaskStats::wait(TaskStats::Poller, 1);
             continue;
         }
 
-        // Polling without an argument both checks for realtime characters and
+        // Polling with an argument both checks for realtime characters and
         // returns a line-oriented command if one is ready.
-        activeChannel = pollChannels(activeLine);
+        auto&    slot    = inputLines[head % nInputLines];
+        Channel* channel = pollChannels(slot.line);
+        if (channel) {
+            slot.channel    = channel;
+            slot.auth_level = channel->authLevel();
+            inputHead       = head + 1;
+            TaskStats::notify(TaskStats::Main);
+        } else {
+            TaskStats::wait(TaskStats::Poller, 1);
+        }
     }
 }
 
+// Returns once the poller is parked between passes, holding nothing
 void stop_polling() {
     if (pollingTask) {
-        vTaskSuspend(pollingTask);
+        pollingStop = true;
+        TaskStats::notify(TaskStats::Poller);
+        while (!pollingParked) {
+            vTaskDelay(1);
+        }
     }
 }
 
 void start_polling() {
     if (pollingTask) {
-        vTaskResume(pollingTask);
+        pollingStop = false;
+        TaskStats::notify(TaskStats::Poller);
     } else {
         xTaskCreatePinnedToCore(polling_loop,      // task
                                 "poller",          // name for task
@@ -263,27 +473,31 @@ static void check_startup_state() {
 
 void protocol_main_loop() {
     check_startup_state();
+    TaskStats::start(TaskStats::Main);
     start_polling();
 
     // ---------------------------------------------------------------------------------
     // Primary loop! Upon a system abort, this exits back to main() to reset the system.
     // This is also where the system idles while waiting for something to do.
     // ---------------------------------------------------------------------------------
-    for (;; vTaskDelay(0)) {
-        if (activeChannel) {
+    for (;;) {
+        uint32_t tail = inputTail;
+        bool     busy = tail != inputHead;
+        if (busy) {
             // The input polling task has collected a line of input
+            auto& slot = inputLines[tail % nInputLines];
 #ifdef DEBUG_REPORT_ECHO_RAW_LINE_RECEIVED
-            report_echo_line_received(activeLine, allChannels);
+            report_echo_line_received(slot.line, allChannels);
 #endif
 
-            Error status_code = execute_line(activeLine, *activeChannel, WebUI::AuthenticationLevel::LEVEL_GUEST);
+            Error status_code = execute_line(slot.line, *slot.channel, slot.auth_level);
 
             // Tell the channel that the line has been processed.
-            activeChannel->ack(status_code);
+            slot.channel->ack(status_code);
 
-            // Tell the input polling task that the line has been processed,
-            // so it can give us another one when available
-            activeChannel = nullptr;
+            // Give the slot back to the input polling task
+            inputTail = tail + 1;
+            TaskStats::notify(TaskStats::Poller);
         }
 
         // Auto-cycle start any queued moves.
@@ -291,6 +505,9 @@ void protocol_main_loop() {
         protocol_execute_realtime();  // Runtime command check point.
         if (sys.abort) {
             stop_polling();
+            // Lines that were received before the reset are discarded, like the
+            // characters that flushRx() drops
+            inputTail = inputHead.load();
             return;  // Bail to main() program loop to reset system.
         }
 
@@ -309,6 +526,26 @@ void protocol_main_loop() {
             idleEndTime = 0;  //
             config->_axes->set_disable(true);
         }
+
+        // Motion needs the step segment buffer refilled all the time.  Otherwise
+        // there is nothing to do until the poller delivers a line or something
+        // sends an event, and both of those wake us up.  The one tick timeout
+        // covers the realtime flags that are set without an event.
+        switch (sys.state) {
+            case State::ConfigAlarm:
+            case State::Alarm:
+            case State::CheckMode:
+            case State::Idle:
+            case State::Sleep:
+                if (!busy && !plan_get_current_block()) {
+                    TaskStats::wait(TaskStats::Main, 1);
+                    continue;
+                }
+                break;
+            default:
+                break;
+        }
+        vTaskDelay(0);
     }
     return; /* Never reached */
 }
@@ -1038,16 +1275,17 @@ xQueueHandle event_queue;
 
 void protocol_init() {
     event_queue   = xQueueCreate(10, sizeof(EventItem));
-    message_queue = xQueueCreate(10, sizeof(LogMessage));
 }
 
 void IRAM_ATTR protocol_send_event_from_ISR(Event* evt, void* arg) {
     EventItem item { evt, arg };
     xQueueSendFromISR(event_queue, &item, NULL);
+    TaskStats::notify_from_ISR(TaskStats::Main);
 }
 void protocol_send_event(Event* evt, void* arg) {
     EventItem item { evt, arg };
     xQueueSend(event_queue, &item, 0);
+    TaskStats::notify(TaskStats::Main);
 }
 void protocol_handle_events() {
     EventItem item;
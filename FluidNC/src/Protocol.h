@@ -11,6 +11,8 @@
 #include <freertos/queue.h>
 #include "Config.h"
 
+#include <atomic>
+
 // Line buffer size from the serial input stream to be executed.Also, governs the size of
 // each of the startup blocks, as they are each stored as a string of this size.
 //
@@ -101,6 +103,10 @@ extern xQueueHandle event_queue;
 
 extern bool pollingPaused;
 
+// True while a line from channel is waiting for or being executed by the main loop,
+// so the channel must not be deleted yet
+bool protocol_has_lines_from(Channel* channel);
+
 struct EventItem {
     Event* event;
     void*  arg;
@@ -116,7 +122,10 @@ inline void protocol_send_event(Event* evt, int arg) {
 void protocol_send_event_from_ISR(Event* evt, void* arg = 0);
 
 void send_line(Channel& channel, const char* message);
-void send_line(Channel& channel, const std::string* message);
 void send_line(Channel& channel, const std::string& message);
 
 void drain_messages();
+void output_forget(Channel& channel);
+
+// Lines that were dropped because a channel did not take its output in time
+extern std::atomic<uint32_t> output_dropped_lines;
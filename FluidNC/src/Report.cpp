@@ -26,12 +26,14 @@
 #include "Limits.h"                      // limits_get_state
 #include "Planner.h"                     // plan_get_block_buffer_available
 #include "Stepper.h"                     // step_count
+#include "StepperStats.h"                // StepperStats::probes
 #include "Platform.h"                    // WEAK_LINK
 #include "WebUI/NotificationsService.h"  // WebUI::notificationsService
 #include "WebUI/WifiConfig.h"            // wifi_config
 #include "WebUI/BTConfig.h"              // bt_config
 #include "WebUI/WebSettings.h"
 #include "InputFile.h"
+#include "ReportBuffer.h"
 
 #include <map>
 #include <freertos/task.h>
@@ -80,10 +82,9 @@ Counter report_wco_counter = 0;
 static const int coordStringLen = 20;
 static const int axesStringLen  = coordStringLen * MAX_N_AXIS;
 
-// Sends the axis values to the output channel
-static std::string report_util_axis_values(const float* axis_value) {
-    std::ostringstream msg;
-    auto               n_axis = config->_axes->_numberAxis;
+// Formats the axis values
+static void report_util_axis_values(const float* axis_value, ReportBuffer& msg) {
+    auto n_axis = config->_axes->_numberAxis;
     for (size_t idx = 0; idx < n_axis; idx++) {
         int   decimals;
         float value = axis_value[idx];
@@ -101,12 +102,17 @@ static std::string report_util_axis_values(const float* axis_value) {
                 decimals = 3;  // Report mm to 3 decimal places
             }
         }
-        msg << std::fixed << std::setprecision(decimals) << value;
+        msg.fixed(value, decimals);
         if (idx < (n_axis - 1)) {
-            msg << ",";
+            msg.add(',');
         }
     }
-    return msg.str();
+}
+
+static std::string report_util_axis_values(const float* axis_value) {
+    ReportBuffer msg;
+    report_util_axis_values(axis_value, msg);
+    return msg.c_str();
 }
 
 std::map<Message, const char*> MessageText = {
@@ -489,15 +495,14 @@ const char* state_name() {
     return "";
 }
 
-static std::string pinString() {
-    std::string msg;
-    bool        prefixNeeded = true;
+static void pinString(ReportBuffer& msg) {
+    bool prefixNeeded = true;
     if (config->_probe->get_state()) {
         if (prefixNeeded) {
             prefixNeeded = false;
-            msg += "|Pn:";
+            msg.add("|Pn:");
         }
-        msg += 'P';
+        msg.add('P');
     }
 
     MotorMask lim_pin_state = limits_get_state();
@@ -508,22 +513,22 @@ static std::string pinString() {
                 bitnum_is_true(lim_pin_state, Machine::Axes::motor_bit(axis, 1))) {
                 if (prefixNeeded) {
                     prefixNeeded = false;
-                    msg += "|Pn:";
+                    msg.add("|Pn:");
                 }
-                msg += config->_axes->axisName(axis);
+                msg.add(config->_axes->axisName(axis));
             }
         }
     }
 
-    std::string ctrl_pin_report = config->_control->report_status();
-    if (ctrl_pin_report.length()) {
-        if (prefixNeeded) {
-            prefixNeeded = false;
-            msg += "|Pn:";
+    for (auto pin : config->_control->_pins) {
+        if (pin->get()) {
+            if (prefixNeeded) {
+                prefixNeeded = false;
+                msg.add("|Pn:");
+            }
+            msg.add(pin->letter());
         }
-        msg += ctrl_pin_report;
     }
-    return msg;
 }
 
 // Define this to do something if a debug request comes in over serial
@@ -535,23 +540,28 @@ void report_realtime_debug() {}
 // requires as it minimizes the computational overhead to keep running smoothly,
 // especially during g-code programs with fast, short line segments and high frequency reports (5-20Hz).
 void report_realtime_status(Channel& channel) {
-    LogStream msg(channel, "<");
-    msg << state_name();
+    // Built in a fixed buffer, since senders poll this many times a second
+    ReportBuffer msg;
+    msg.add('<');
+    msg.add(state_name());
 
     // Report position
     float* print_position = get_mpos();
     if (bits_are_true(status_mask->get(), RtStatus::Position)) {
-        msg << "|MPos:";
+        msg.add("|MPos:");
     } else {
-        msg << "|WPos:";
+        msg.add("|WPos:");
         mpos_to_wpos(print_position);
     }
-    msg << report_util_axis_values(print_position).c_str();
+    report_util_axis_values(print_position, msg);
 
     // Returns planner and serial read buffer states.
 
     if (bits_are_true(status_mask->get(), RtStatus::Buffer)) {
-        msg << "|Bf:" << plan_get_block_buffer_available() << "," << channel.rx_buffer_available();
+        msg.add("|Bf:");
+        msg.integer(plan_get_block_buffer_available());
+        msg.add(',');
+        msg.integer(channel.rx_buffer_available());
     }
 
     if (config->_useLineNumbers) {
@@ -560,7 +570,8 @@ void report_realtime_status(Channel& channel) {
         if (cur_block != NULL) {
             uint32_t ln = cur_block->line_number;
             if (ln > 0) {
-                msg << "|Ln:" << ln;
+                msg.add("|Ln:");
+                msg.integer(ln);
             }
         }
     }
@@ -570,9 +581,12 @@ void report_realtime_status(Channel& channel) {
     if (config->_reportInches) {
         rate /= MM_PER_INCH;
     }
-    msg << "|FS:" << setprecision(0) << rate << "," << sys.spindle_speed;
+    msg.add("|FS:");
+    msg.fixed(rate, 0);
+    msg.add(',');
+    msg.integer(sys.spindle_speed);
 
-    msg << pinString();
+    pinString(msg);
 
     if (report_wco_counter > 0) {
         report_wco_counter--;
@@ -591,7 +605,8 @@ void report_realtime_status(Channel& channel) {
         if (report_ovr_counter == 0) {
             report_ovr_counter = 1;  // Set override on next report.
         }
-        msg << "|WCO:" << report_util_axis_values(get_wco()).c_str();
+        msg.add("|WCO:");
+        report_util_axis_values(get_wco(), msg);
     }
 
     if (report_ovr_counter > 0) {
@@ -609,19 +624,24 @@ void report_realtime_status(Channel& channel) {
                 break;
         }
 
-        msg << "|Ov:" << int(sys.f_override) << "," << int(sys.r_override) << "," << int(sys.spindle_speed_ovr);
+        msg.add("|Ov:");
+        msg.integer(sys.f_override);
+        msg.add(',');
+        msg.integer(sys.r_override);
+        msg.add(',');
+        msg.integer(sys.spindle_speed_ovr);
         SpindleState sp_state      = spindle->get_state();
         CoolantState coolant_state = config->_coolant->get_state();
         if (sp_state != SpindleState::Disable || coolant_state.Mist || coolant_state.Flood) {
-            msg << "|A:";
+            msg.add("|A:");
             switch (sp_state) {
                 case SpindleState::Disable:
                     break;
                 case SpindleState::Cw:
-                    msg << "S";
+                    msg.add('S');
                     break;
                 case SpindleState::Ccw:
-                    msg << "C";
+                    msg.add('C');
                     break;
                 case SpindleState::Unknown:
                     break;
@@ -629,25 +649,80 @@ void report_realtime_status(Channel& channel) {
 
             auto coolant = coolant_state;
             if (coolant.Flood) {
-                msg << "F";
+                msg.add('F');
             }
             if (coolant.Mist) {
-                msg << "M";
+                msg.add('M');
             }
         }
     }
-    if (InputFile::_progress.length()) {
-        msg << "|" + InputFile::_progress;
+    auto& progress = InputFile::_progress;
+    if (progress.file) {
+        float percent = progress.size ? progress.consumed * 100.0f / progress.size : 0.0f;
+        msg.add("|SD:");
+        msg.fixed(percent, 2);
+        msg.add(',');
+        msg.add(progress.path);
+        msg.add("|SDLn:");
+        msg.integer(progress.line);
     }
 #ifdef DEBUG_STEPPER_ISR
-    msg << "|ISRs:" << Stepper::isr_count;
+    msg.add("|ISRs:");
+    msg.integer(Stepper::isr_count);
 #endif
+    if (StepperStats::_inStatus) {
+        auto& isr = StepperStats::probes[StepperStats::PulseFunc];
+        msg.add("|ISR:");
+        msg.integer(isr.avg());
+        msg.add(',');
+        msg.integer(isr.max);
+        msg.add(',');
+        msg.integer(StepperStats::underruns());
+    }
 #ifdef DEBUG_REPORT_HEAP
-    msg << "|Heap:" << esp.getHeapSize();
+    msg.add("|Heap:");
+    msg.integer(esp.getHeapSize());
 #endif
-    msg << ">";
-    // The DebugStream destructor sends the line
-    // when msg goes out of scope
+    msg.add('>');
+    send_line(channel, msg.c_str());
+}
+
+// Compact status frame, for auto reports at high rates.  Every field is upper case hex
+// of a fixed width, so the frame costs little to build and a sender can take it apart
+// by position.  It is a text line like the others, so it can go to any channel:
+//
+//   {S<steps>...<feed><spindle><bf><line>}
+//
+//   S        1 digit   State, as the number of the State enum: 0 Idle, 1 Alarm, 4 Cycle ...
+//   steps    8 digits  Machine position of each axis in motor steps, two's complement
+//   feed     6 digits  Realtime feed rate in mm/min, rounded
+//   spindle  6 digits  Spindle speed
+//   bf       4 digits  Free planner blocks, as planner_blocks can be up to 4000
+//   line     8 digits  Line number of the executing block, as in Ln:
+//
+// The number of axes follows from the length of the frame, which is 51 characters for three
+// axes.
+void report_compact_status(Channel& channel) {
+    ReportBuffer msg;
+    msg.add('{');
+    msg.hex(uint32_t(sys.state), 1);
+
+    auto n_axis = config->_axes->_numberAxis;
+    for (size_t axis = 0; axis < n_axis; axis++) {
+        msg.hex(uint32_t(get_axis_motor_steps(axis)), 8);
+    }
+
+    const uint32_t maxField = 0xffffff;
+    float          rate     = Stepper::get_realtime_rate();
+    msg.hex(std::min(uint32_t(rate + 0.5f), maxField), 6);
+    msg.hex(std::min(uint32_t(sys.spindle_speed), maxField), 6);
+    msg.hex(plan_get_block_buffer_available(), 4);
+
+    plan_block_t* cur_block = plan_get_current_block();
+    msg.hex(cur_block ? cur_block->line_number : 0, 8);
+
+    msg.add('}');
+    send_line(channel, msg.c_str());
 }
 
 void hex_msg(uint8_t* buf, const char* prefix, int len) {
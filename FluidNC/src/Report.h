@@ -59,8 +59,9 @@ void report_init_message(Channel& channel);
 // Prints an echo of the pre-parsed line received right before execution.
 void report_echo_line_received(char* line, Channel& channel);
 
-// Prints realtime status report
+// Prints realtime status report, in full or as a compact frame
 void report_realtime_status(Channel& channel);
+void report_compact_status(Channel& channel);
 
 // Prints recorded probe position
 void report_probe_parameters(Channel& channel);
@@ -0,0 +1,98 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "ReportBuffer.h"
+
+#include <cmath>
+#include <cstdio>
+
+void ReportBuffer::add(char c) {
+    if (_len < size - 1) {
+        _buf[_len++] = c;
+        _buf[_len]   = '\0';
+    }
+}
+
+void ReportBuffer::add(const char* s) {
+    while (*s && _len < size - 1) {
+        _buf[_len++] = *s++;
+    }
+    _buf[_len] = '\0';
+}
+
+// Writes the digits of value, zero-padded on the left to at least width digits
+static size_t format_digits(char* out, uint64_t value, int width) {
+    char   digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+    while (int(n) < width) {
+        digits[n++] = '0';
+    }
+    for (size_t i = 0; i < n; i++) {
+        out[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+void ReportBuffer::integer(int64_t value) {
+    char     digits[24];
+    size_t   n         = 0;
+    uint64_t magnitude = value;
+    if (value < 0) {
+        digits[n++] = '-';
+        magnitude   = -magnitude;
+    }
+    n += format_digits(digits + n, magnitude, 1);
+    digits[n] = '\0';
+    add(digits);
+}
+
+void ReportBuffer::hex(uint32_t value, int digits) {
+    static const char nibbles[] = "0123456789ABCDEF";
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+        add(nibbles[(value >> shift) & 0xf]);
+    }
+}
+
+void ReportBuffer::fixed(float value, int decimals) {
+    static const uint32_t scales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+    if (decimals < 0) {
+        decimals = 0;
+    } else if (decimals > 6) {
+        decimals = 6;
+    }
+    uint32_t scale = scales[decimals];
+
+    // A float has 24 significant bits and the scale at most 20, so the product
+    // is exact in a double, and rounding it here rounds the exact value of the
+    // float, as printf does.  Exact ties go to even, also as printf does.
+    double scaled = std::fabs(double(value)) * scale;
+    if (!std::isfinite(scaled) || scaled >= 1e18) {
+        // Too big for the integer path, and never seen in practice
+        char text[64];
+        snprintf(text, sizeof(text), "%.*f", decimals, double(value));
+        add(text);
+        return;
+    }
+    uint64_t whole    = uint64_t(scaled);
+    double   fraction = scaled - double(whole);
+    if (fraction > 0.5 || (fraction == 0.5 && (whole & 1))) {
+        ++whole;
+    }
+
+    char   text[48];
+    size_t n = 0;
+    if (std::signbit(value)) {
+        text[n++] = '-';
+    }
+    n += format_digits(text + n, whole / scale, 1);
+    if (decimals) {
+        text[n++] = '.';
+        n += format_digits(text + n, whole % scale, decimals);
+    }
+    text[n] = '\0';
+    add(text);
+}
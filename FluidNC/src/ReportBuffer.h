@@ -0,0 +1,40 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  ReportBuffer.h - builds a report line in a fixed buffer
+
+  Reports that are sent many times a second, like the <...> status report, are built
+  here instead of in a LogStream, so they do not touch the heap.  Numbers are written
+  straight into the buffer.  fixed() gives the same digits as std::fixed with
+  std::setprecision, which the reports have always used, without going through
+  printf.  Text that does not fit in the buffer is dropped.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+class ReportBuffer {
+public:
+    static const size_t size = 400;
+
+private:
+    char   _buf[size];
+    size_t _len = 0;
+
+public:
+    ReportBuffer() { _buf[0] = '\0'; }
+
+    ReportBuffer(const ReportBuffer&) = delete;
+    ReportBuffer& operator=(const ReportBuffer&) = delete;
+
+    void add(char c);
+    void add(const char* s);
+    void integer(int64_t value);
+    void hex(uint32_t value, int digits);  // The low digits nibbles, upper case
+    void fixed(float value, int decimals);
+
+    const char* c_str() const { return _buf; }
+    size_t      length() const { return _len; }
+};
@@ -206,6 +206,7 @@ void AllChannels::deregistration(Channel* channel) {
     }
     _channelq.erase(std::remove(_channelq.begin(), _channelq.end(), channel), _channelq.end());
     _mutex.unlock();
+    output_forget(*channel);
 }
 
 void AllChannels::listChannels(Channel& out) {
@@ -268,6 +269,11 @@ Channel* AllChannels::pollLine(char* line) {
     Channel* deadChannel;
     while (xQueueReceive(_killQueue, &deadChannel, 0)) {
         deregistration(deadChannel);
+        if (protocol_has_lines_from(deadChannel)) {
+            // The main loop still has lines from it; try again on the next poll
+            xQueueSend(_killQueue, &deadChannel, 0);
+            break;
+        }
         delete deadChannel;
     }
 
@@ -297,20 +303,9 @@ AllChannels allChannels;
 
 Channel* pollChannels(char* line) {
     poll_gpios();
-    // Throttle polling when we are not ready for a line, thus preventing
-    // planner buffer starvation due to not calling Stepper::prep_buffer()
-    // frequently enough, which is normally called periodically at the end
-    // of protocol_exec_rt_system() via protocol_execute_realtime().
-    static int counter = 0;
-    if (line) {
-        counter = 0;
-    }
-    if (counter > 0) {
-        --counter;
-        return nullptr;
-    }
-    counter = 50;
-
+    // This used to skip most of the polls made while no line was wanted, because
+    // the poller spun on them.  It now sleeps between passes that find nothing,
+    // so every pass polls, and realtime characters are seen within a tick.
     Channel* retval = allChannels.pollLine(line);
 
     WebUI::COMMANDS::handle();      // Handles ESP restart
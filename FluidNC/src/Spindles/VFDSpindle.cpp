@@ -24,6 +24,7 @@
 #include "../MotionControl.h"  // mc_reset
 #include "../Protocol.h"       // rtAlarm
 #include "../Report.h"         // hex message
+#include "../TaskStats.h"      // TaskStats::Blocked
 
 #include <freertos/task.h>
 #include <freertos/queue.h>
@@ -75,7 +76,19 @@ namespace Spindles {
         uint8_t       rx_message[VFD_RS485_MAX_MSG_SIZE];
         bool          safetyPollingEnabled = instance->safety_polling();
 
-        for (; true; delay_ms(VFD_RS485_POLL_RATE)) {
+        // Time spent waiting for the poll interval or for the VFD is not counted
+        // as busy in $Sys/Tasks
+        TaskStats::start(TaskStats::Vfd);
+        auto wait_ms = [](uint32_t ms) {
+            TaskStats::Blocked blocked(TaskStats::Vfd);
+            delay_ms(ms);
+        };
+        auto read = [&uart](uint8_t* buffer, size_t length) {
+            TaskStats::Blocked blocked(TaskStats::Vfd);
+            return uart.timedReadBytes(buffer, length, response_ticks);
+        };
+
+        for (; true; wait_ms(VFD_RS485_POLL_RATE)) {
             std::atomic_thread_fence(std::memory_order::memory_order_seq_cst);  // read fence for settings
             response_parser parser = nullptr;
 
@@ -175,11 +188,14 @@ namespace Spindles {
                 // Flush the UART and write the data:
                 uart.flush();
                 uart.write(next_cmd.msg, next_cmd.tx_length);
-                uart.flushTxTimed(response_ticks);
+                {
+                    TaskStats::Blocked blocked(TaskStats::Vfd);
+                    uart.flushTxTimed(response_ticks);
+                }
 
                 // Read the response
                 size_t read_length  = 0;
-                size_t current_read = uart.timedReadBytes(rx_message, next_cmd.rx_length, response_ticks);
+                size_t current_read = read(rx_message, next_cmd.rx_length);
                 read_length += current_read;
 
                 // Apparently some Huanyang report modbus errors in the correct way, and the rest not. Sigh.
@@ -190,7 +206,7 @@ namespace Spindles {
 
                 while (read_length < next_cmd.rx_length && current_read > 0) {
                     // Try to read more; we're not there yet...
-                    current_read = uart.timedReadBytes(rx_message + read_length, next_cmd.rx_length - read_length, response_ticks);
+                    current_read = read(rx_message + read_length, next_cmd.rx_length - read_length);
                     read_length += current_read;
                 }
 
@@ -228,7 +244,7 @@ namespace Spindles {
 
                     // Wait a bit before we retry. Set the delay to poll-rate. Not sure
                     // if we should use a different value...
-                    delay_ms(VFD_RS485_POLL_RATE);
+                    wait_ms(VFD_RS485_POLL_RATE);
 
 #ifdef DEBUG_TASK_STACK
                     static UBaseType_t uxHighWaterMark = 0;
@@ -0,0 +1,82 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "StepTrace.h"
+
+#include <esp_attr.h>  // IRAM_ATTR
+
+namespace StepTrace {
+    bool _active = false;
+
+    static Record*           ring     = nullptr;
+    static uint32_t          ringMask = 0;
+    static volatile uint32_t ringHead = 0;  // Written only by the ISR
+    static volatile uint32_t ringTail = 0;  // Written only by read()
+    static uint32_t          lost     = 0;
+
+    static uint32_t now    = 0;  // Time of the current ISR tick
+    static uint32_t period = 0;  // Time between ISR ticks
+
+    bool start(size_t capacity) {
+        stop();
+
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        ring = new Record[size];
+        if (!ring) {
+            return false;
+        }
+        ringMask = size - 1;
+        ringHead = 0;
+        ringTail = 0;
+        lost     = 0;
+        now      = 0;
+        period   = 0;
+        _active  = true;
+        return true;
+    }
+
+    void stop() {
+        _active = false;
+        if (ring) {
+            delete[] ring;
+            ring = nullptr;
+        }
+    }
+
+    size_t read(Record* dest, size_t maxRecords) {
+        size_t   n    = 0;
+        uint32_t tail = ringTail;
+        while (n < maxRecords && tail != ringHead) {
+            dest[n++] = ring[tail & ringMask];
+            tail++;
+        }
+        ringTail = tail;
+        return n;
+    }
+
+    uint32_t overruns() { return lost; }
+
+    // Called at the start of every pulse_func() tick, with the masks that are about
+    // to be sent to Axes::step().  The tick happens one period after the previous one.
+    void IRAM_ATTR tick(uint8_t step_mask, uint8_t dir_mask) {
+        now += period;
+        if (step_mask == 0) {
+            return;
+        }
+        uint32_t head = ringHead;
+        if (head - ringTail > ringMask) {
+            lost++;
+            return;
+        }
+        auto& r     = ring[head & ringMask];
+        r.ticks     = now;
+        r.step_mask = step_mask;
+        r.dir_mask  = dir_mask;
+        ringHead    = head + 1;
+    }
+
+    // Called from pulse_func() when a new segment changes the ISR period
+    void IRAM_ATTR set_period(uint16_t timerTicks) { period = timerTicks; }
+}
@@ -0,0 +1,43 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  StepTrace.h - records the step and direction masks produced by the stepper ISR
+
+  Every Stepper::pulse_func() tick that steps at least one axis is recorded with the
+  time of the tick, in units of stepping timer ticks since tracing started.  Ticks that
+  do not step any axis only advance the time.  The records go into a ring buffer that
+  the foreground drains with read(), so whole jobs can be captured and compared against
+  a known-good trace to prove that changes to the planner or the segment generator do
+  not alter the step output.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace StepTrace {
+    struct Record {
+        uint32_t ticks;      // Stepping timer ticks since start()
+        uint8_t  step_mask;  // Axes that stepped on this tick
+        uint8_t  dir_mask;   // Direction bits in effect for this tick
+    };
+
+    // Allocates a ring of the given number of records (rounded up to a power of two) and
+    // starts recording.  Returns false if the memory could not be allocated.
+    bool start(size_t capacity);
+
+    // Stops recording and releases the ring
+    void stop();
+
+    // Copies up to maxRecords of the oldest unread records to dest.  Returns the number copied.
+    size_t read(Record* dest, size_t maxRecords);
+
+    // Number of records lost because the ring was full
+    uint32_t overruns();
+
+    // Called from the stepper ISR
+    extern bool _active;
+    void        tick(uint8_t step_mask, uint8_t dir_mask);
+    void        set_period(uint16_t timerTicks);
+}
@@ -15,7 +15,10 @@
 #include "StepperPrivate.h"
 #include "Planner.h"
 #include "Protocol.h"
+#include "StepTrace.h"
+#include "StepperStats.h"
 #include <esp_attr.h>  // IRAM_ATTR
+#include <atomic>
 #include <cmath>
 
 using namespace Stepper;
@@ -33,6 +36,16 @@ struct st_block_t {
     uint32_t step_event_count;
     uint8_t  direction_bits;
     bool     is_pwm_rate_adjusted;  // Tracks motions that require constant laser power/rate
+
+    // Raster blocks. The pixels are counted with a Bresenham counter driven by the steps of the
+    // axis that makes a step on every step event of the block.
+    const uint8_t* raster;         // Per-pixel power, or nullptr
+    uint32_t       raster_mark;    // Raster pool position when the block was queued
+    uint32_t       raster_events;  // Step events of the block, without the AMASS shift
+    uint32_t       raster_error;   // Pixel counter, advanced by the ISR
+    uint16_t       raster_pixels;
+    uint16_t       raster_pixel;  // Pixel being fired, advanced by the ISR
+    uint8_t        raster_axis;
 };
 static volatile st_block_t* st_block_buffer = nullptr;
 
@@ -40,16 +53,31 @@ static volatile st_block_t* st_block_buffer = nullptr;
 // algorithm to execute, which are "checked-out" incrementally from the first block in the
 // planner buffer. Once "checked-out", the steps in the segments buffer cannot be modified by
 // the planner, where the remaining planner block steps still can.
+// NOTE: The Bresenham increments are decoded for the AMASS level of the segment when it is
+// prepped, so loading a segment in the ISR is only a pointer update.
 struct segment_t {
-    uint16_t     n_step;             // Number of step events to be executed for this segment
-    uint16_t     isrPeriod;          // Time to next ISR tick, in units of timer ticks
-    uint8_t      st_block_index;     // Stepper block data index. Uses this information to execute this segment.
-    uint8_t      amass_level;        // AMASS level for the ISR to execute this segment
-    uint32_t     spindle_dev_speed;  // Spindle speed scaled to the device
-    SpindleSpeed spindle_speed;      // Spindle speed in GCode units
+    uint16_t     n_step;                // Number of step events to be executed for this segment
+    uint16_t     isrPeriod;             // Time to next ISR tick, in units of timer ticks
+    uint8_t      st_block_index;        // Stepper block data index. Uses this information to execute this segment.
+    uint8_t      amass_level;           // AMASS level for the ISR to execute this segment
+    uint8_t      direction_bits;        // Copied from the stepper block
+    uint32_t     step_event_count;      // Copied from the stepper block
+    uint32_t     steps[MAX_N_AXIS];     // Bresenham increment of each axis at this AMASS level
+    uint32_t     spindle_dev_speed;     // Spindle speed scaled to the device
+    SpindleSpeed spindle_speed;         // Spindle speed in GCode units
 };
 static segment_t* segment_buffer = nullptr;
 
+// The segment buffer is a single-producer, single-consumer ring. prep_buffer() is the only
+// writer of segment_head and the stepper ISR the only writer of segment_tail. The indices
+// run freely and are masked when used, so the ring size is a power of two and the ISR never
+// wraps or bounds-checks an index. A release store of an index publishes the segment it
+// passes over, and the acquire load on the other side makes the segment visible.
+static uint32_t              segment_mask     = 0;  // Ring size - 1
+static uint32_t              segment_capacity = 0;  // Segments that may be queued at once
+static std::atomic<uint32_t> segment_head;          // Next segment to prep
+static std::atomic<uint32_t> segment_tail;          // Segment the ISR executes
+
 void Stepper::init() {
     if (st_block_buffer) {
         delete[] st_block_buffer;
@@ -58,7 +86,13 @@ void Stepper::init() {
     if (segment_buffer) {
         delete[] segment_buffer;
     }
-    segment_buffer = new segment_t[config->_stepping->_segments];
+    uint32_t size = 1;
+    while (size < config->_stepping->_segments) {
+        size <<= 1;
+    }
+    segment_buffer   = new segment_t[size];
+    segment_mask     = size - 1;
+    segment_capacity = config->_stepping->_segments - 1;
 }
 
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
@@ -71,20 +105,17 @@ typedef struct {
     uint8_t  execute_step;  // Flags step execution for each interrupt.
     uint8_t  step_outbits;  // The next stepping-bits to be output
     uint8_t  dir_outbits;
-    uint32_t steps[MAX_N_AXIS];
 
     uint16_t             step_count;        // Steps remaining in line segment motion
     uint8_t              exec_block_index;  // Tracks the current st_block index. Change indicates new block.
     volatile st_block_t* exec_block;        // Pointer to the block data for the segment being executed
     volatile segment_t*  exec_segment;      // Pointer to the segment being executed
+
+    uint32_t raster_dev_speed;  // Device speed of a full power pixel in the current segment
+    bool     raster_pending;    // The next step enters a new pixel
 } stepper_t;
 static stepper_t st;
 
-// Step segment ring buffer indices
-static volatile uint32_t segment_buffer_tail;
-static volatile uint32_t segment_buffer_head;
-static uint32_t          segment_next_head;
-
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t*        pl_block;       // Pointer to the planner block being prepped
@@ -115,12 +146,189 @@ typedef struct {
     float accelerate_until;  // Acceleration ramp end measured from end of block (mm)
     float decelerate_after;  // Deceleration ramp start measured from end of block (mm)
 
+    // S-curve ramp state, used when the block has a jerk limit. Each ramp covers the same time and
+    // distance as its trapezoidal counterpart, unless it is stretched to meet the jerk limit.
+    bool  scurve;            // Ramps of the executing block follow an S-curve
+    float ramp_start_speed;  // Speed at the start of the current ramp (mm/min)
+    float ramp_delta_speed;  // Signed speed change over the current ramp (mm/min)
+    float ramp_start_accel;  // Acceleration at the start of the current ramp (mm/min^2)
+    float current_accel;     // Acceleration at the end of the segment buffer (mm/min^2)
+    float ramp_duration;     // Duration of the current ramp (min)
+    float ramp_elapsed;      // Time elapsed in the current ramp (min)
+    float ramp_start_mm;     // Ramp start measured from end of block (mm)
+
+    // Arc block state. Each segment of an arc block gets its own stepper block with the steps
+    // from the end of the previous segment to the point on the arc where the segment ends.
+    int32_t arc_steps[MAX_N_AXIS];  // Steps prepped since the start of the arc block
+    float   arc_cos_start;          // Cosine of the arc start angle
+    float   arc_sin_start;          // Sine of the arc start angle
+    bool    arc_slot_free;          // The stepper block taken when the arc loaded has no segment yet
+
     float        inv_rate;  // Used by PWM laser mode to speed up segment calculations.
     SpindleSpeed current_spindle_speed;
 
 } st_prep_t;
 static st_prep_t prep;
 
+// Input shaping state. The shaper clock advances by the ISR period on every tick, so idle time
+// between motions does not count towards the shaper delays.
+static uint32_t shaper_clock    = 0;
+static uint16_t shaper_period   = 0;
+static uint8_t  shaped_dir_bits = 0;  // Direction bits last emitted on the shaped axes
+
+// ISR period used to emit the tail of shaped motion after the segment buffer runs empty
+const uint16_t shaperDrainPeriod = Machine::Stepping::fStepperTimer / 40000;
+
+// Passes the Bresenham steps of the shaped axes through their shapers, replacing the step and
+// direction bits of those axes with the shaped output. Called once per ISR tick while shaping.
+static void IRAM_ATTR shape_steps(uint8_t commanded_dir_bits) {
+    auto     axes   = config->_axes;
+    AxisMask shaped = Machine::Axes::shapedMask;
+
+    shaper_clock += shaper_period;
+    uint8_t step_bits = st.step_outbits & ~shaped;
+    for (int axis = 0; axis < axes->_numberAxis; axis++) {
+        if (bitnum_is_true(shaped, axis)) {
+            auto shaper = axes->_axis[axis]->_shaper;
+            int  step   = shaper->tick(shaper_clock, bitnum_is_true(st.step_outbits, axis), bitnum_is_true(commanded_dir_bits, axis));
+            if (step) {
+                set_bitnum(step_bits, axis);
+                if (step < 0) {
+                    set_bitnum(shaped_dir_bits, axis);
+                } else {
+                    clear_bitnum(shaped_dir_bits, axis);
+                }
+            }
+        }
+    }
+    st.step_outbits = step_bits;
+    st.dir_outbits  = (commanded_dir_bits & ~shaped) | (shaped_dir_bits & shaped);
+}
+
+// Shaping is bypassed while homing so that the switches see the commanded motion.
+static bool IRAM_ATTR shaping() {
+    return Machine::Axes::shapedMask && sys.state != State::Homing;
+}
+
+static bool IRAM_ATTR shapers_busy() {
+    auto axes = config->_axes;
+    for (int axis = 0; axis < axes->_numberAxis; axis++) {
+        if (bitnum_is_true(Machine::Axes::shapedMask, axis) && axes->_axis[axis]->_shaper->busy()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the distance of an S-curve ramp between two speeds. That is the distance of the
+// trapezoidal ramp, or longer if the ramp must take more time to stay within the jerk limit.
+static float scurve_ramp_mm(float from_speed, float to_speed, const plan_block_t* pl_block) {
+    float delta_speed  = fabsf(to_speed - from_speed);
+    float trapezoid_mm = fabsf(to_speed * to_speed - from_speed * from_speed) / (2.0f * pl_block->acceleration);
+    float jerk_mm      = 0.5f * (from_speed + to_speed) * sqrtf(SCURVE_JERK_FACTOR * delta_speed / pl_block->jerk);
+    return MAX(trapezoid_mm, jerk_mm);
+}
+
+// Stretches the ramps of a planned profile that are too short for the jerk limit. The extra
+// distance comes out of the cruise, and the cruise speed is lowered when there is not enough of
+// it. Deceleration-only profiles keep their planned ramp, as do ramps whose end speeds alone
+// leave no room to stretch, since the planner has fixed the block's entry and exit speeds.
+static void scurve_fit_profile(const plan_block_t* pl_block) {
+    if (prep.ramp_type != RAMP_ACCEL && prep.ramp_type != RAMP_CRUISE) {
+        return;
+    }
+    float span     = pl_block->millimeters - prep.mm_complete;
+    float accel_mm = scurve_ramp_mm(prep.current_speed, prep.maximum_speed, pl_block);
+    float decel_mm = scurve_ramp_mm(prep.maximum_speed, prep.exit_speed, pl_block);
+    if (accel_mm + decel_mm > span) {
+        // Bisect for the highest cruise speed whose ramps fit the block.
+        float fits  = MAX(prep.current_speed, prep.exit_speed);
+        float fails = prep.maximum_speed;
+        for (int i = 0; i < 10; i++) {
+            float speed = 0.5f * (fits + fails);
+            if (scurve_ramp_mm(prep.current_speed, speed, pl_block) + scurve_ramp_mm(speed, prep.exit_speed, pl_block) <= span) {
+                fits = speed;
+            } else {
+                fails = speed;
+            }
+        }
+        prep.maximum_speed = fits;
+        accel_mm           = MIN(scurve_ramp_mm(prep.current_speed, fits, pl_block), span);
+        decel_mm           = MIN(scurve_ramp_mm(fits, prep.exit_speed, pl_block), span - accel_mm);
+    }
+    prep.accelerate_until = pl_block->millimeters - accel_mm;
+    prep.decelerate_after = MIN(prep.mm_complete + decel_mm, prep.accelerate_until);
+    prep.ramp_type        = prep.current_speed < prep.maximum_speed ? RAMP_ACCEL : RAMP_CRUISE;
+}
+
+// Returns the distance in which a feed hold stops from the current speed. A hold that catches an
+// S-curve ramp carries its acceleration into the stop, which is then stretched from the trapezoidal
+// stop time until the acceleration along it stays within the peak acceleration of the axes.
+static float scurve_stop_mm(const plan_block_t* pl_block) {
+    float speed = prep.current_speed;
+    float accel = prep.current_accel;
+    float limit = SCURVE_PEAK_FACTOR * pl_block->acceleration;
+    float T     = speed / pl_block->acceleration;
+    for (int i = 0; i < 20; i++) {
+        float peak = 0.0f;
+        for (int k = 1; k < 16; k++) {
+            float u = k / 16.0f;
+            float w = 1.0f - u;
+            peak    = MAX(peak, fabsf(-speed * 30.0f * u * u * w * w / T + accel * (1.0f - 18.0f * u * u + 32.0f * u * u * u - 15.0f * u * u * u * u)));
+        }
+        if (peak <= limit && fabsf(accel) <= limit) {
+            break;
+        }
+        T *= 1.1f;
+    }
+    return 0.5f * speed * T + 0.1f * accel * T * T;
+}
+
+// Starts an S-curve ramp from the current speed and acceleration that reaches end_speed, with no
+// acceleration, at end_mm from the end of the block. A ramp that starts at rest takes the time of
+// the trapezoidal ramp. A block recomputed mid-ramp starts its new ramp with the acceleration the
+// old one had reached, so the acceleration does not jump. The duration then solves
+// 0.1 * a0 * T^2 + (v0 + v1) / 2 * T = distance, from the distance of the ramp in scurve_advance().
+static void scurve_begin(float start_mm, float end_mm, float end_speed) {
+    float distance        = start_mm - end_mm;
+    float mean_speed      = 0.5f * (prep.current_speed + end_speed);
+    float root            = mean_speed * mean_speed + 0.4f * prep.current_accel * distance;
+    prep.ramp_start_speed = prep.current_speed;
+    prep.ramp_delta_speed = end_speed - prep.current_speed;
+    prep.ramp_start_accel = root >= 0.0f ? prep.current_accel : 0.0f;
+    prep.ramp_start_mm    = start_mm;
+    prep.ramp_elapsed     = 0.0f;
+    if (root < 0.0f) {
+        // Decelerating too hard to carry into the distance left. Restart from zero acceleration.
+        root = mean_speed * mean_speed;
+    }
+    float denominator  = mean_speed + sqrtf(root);
+    prep.ramp_duration = denominator > 0.0f ? distance / denominator * 2.0f : 0.0f;
+}
+
+// Evaluates the S-curve ramp at elapsed time t, updating the current speed and acceleration, and
+// returns the remaining distance to the end of the block. The speed change follows the quintic
+// smoothstep 6u^5 - 15u^4 + 10u^3, and the starting acceleration fades out along the quintic
+// u - 6u^3 + 8u^4 - 3u^5. Both have zero acceleration and jerk at the end of the ramp, and the
+// distance is their integral.
+static float scurve_advance(float t) {
+    float T  = prep.ramp_duration;
+    float u  = t / T;
+    float u2 = u * u;
+    float u3 = u2 * u;
+    float u4 = u3 * u;
+    float u5 = u4 * u;
+    float w  = 1.0f - u;
+
+    float carry        = prep.ramp_start_accel * T;
+    prep.current_speed = prep.ramp_start_speed + prep.ramp_delta_speed * (6.0f * u5 - 15.0f * u4 + 10.0f * u3) +
+                         carry * (u - 6.0f * u3 + 8.0f * u4 - 3.0f * u5);
+    prep.current_accel = prep.ramp_delta_speed * 30.0f * u2 * w * w / T + prep.ramp_start_accel * (1.0f - 18.0f * u2 + 32.0f * u3 - 15.0f * u4);
+    float mm_var       = prep.ramp_start_speed * t + prep.ramp_delta_speed * T * (u5 * u - 3.0f * u5 + 2.5f * u4) +
+                   carry * T * (0.5f * u2 - 1.5f * u4 + 1.6f * u5 - 0.5f * u5 * u);
+    return prep.ramp_start_mm - mm_var;
+}
+
 /* "The Stepper Driver Interrupt" - This timer interrupt is the workhorse, employing
    the venerable Bresenham line algorithm to manage and exactly synchronize multi-axis moves.
    Unlike the popular DDA algorithm, the Bresenham algorithm is not susceptible to numerical
@@ -179,12 +387,45 @@ static st_prep_t prep;
 void IRAM_ATTR Stepper::stop_stepping() {
     config->_axes->unstep();
     st.step_outbits = 0;
+    if (StepTrace::_active) {
+        // Idle time is not part of the trace; the first tick after a restart
+        // continues from the tick that stopped.
+        StepTrace::set_period(0);
+    }
 }
 
 #ifdef DEBUG_STEPPER_ISR
 uint32_t Stepper::isr_count;  // for debugging only
 #endif
 
+// Sets the laser to the power of the current pixel of a raster block
+static void IRAM_ATTR raster_fire(volatile st_block_t* block) {
+    spindle->setSpeedfromISR(st.raster_dev_speed * block->raster[block->raster_pixel] / 255);
+}
+
+// Called for every step of the raster axis, one tick before the step is sent to the motors.
+// Moves to the next pixel when the step crosses into it, and marks the new power to be set
+// right after the step.
+static void IRAM_ATTR raster_step(volatile st_block_t* block) {
+    block->raster_error += block->raster_pixels;
+    if (block->raster_error < block->raster_events) {
+        return;
+    }
+    do {
+        block->raster_error -= block->raster_events;
+        block->raster_pixel++;
+    } while (block->raster_error >= block->raster_events);
+    st.raster_pending = block->raster_pixel < block->raster_pixels;
+}
+
+static void IRAM_ATTR timed_unstep() {
+    auto started = StepperStats::start();
+    config->_axes->unstep();
+    StepperStats::stop(StepperStats::Unstep, started);
+}
+
+static bool IRAM_ATTR pulse_tick();
+
 /**
  * This phase of the ISR should ONLY create the pulses for the steppers.
  * This prevents jitter caused by the interval between the start of the
@@ -197,22 +438,46 @@ bool IRAM_ATTR Stepper::pulse_func() {
 #ifdef DEBUG_STEPPER_ISR
     isr_count++;
 #endif
+    // Reading the cycle counter takes a fixed time, so it does not add jitter
+    auto started = StepperStats::start();
+    bool running = pulse_tick();
+    StepperStats::stop(StepperStats::PulseFunc, started);
+    return running;
+}
+
+static bool IRAM_ATTR pulse_tick() {
     // This is a precaution in case we get a spurious interrupt
     if (!awake) {
         return false;
     }
     auto n_axis = config->_axes->_numberAxis;
 
+    auto stepStarted = StepperStats::start();
     config->_axes->step(st.step_outbits, st.dir_outbits);
+    StepperStats::stop(StepperStats::Step, stepStarted);
+
+    if (st.raster_pending) {
+        st.raster_pending = false;
+        raster_fire(st.exec_block);
+    }
+
+    if (StepTrace::_active) {
+        StepTrace::tick(st.step_outbits, st.dir_outbits);
+    }
 
     // If there is no step segment, attempt to pop one from the stepper buffer
     if (st.exec_segment == NULL) {
         // Anything in the buffer? If so, load and initialize next step segment.
-        if (segment_buffer_head != segment_buffer_tail) {
+        uint32_t tail = segment_tail.load(std::memory_order_relaxed);
+        if (tail != segment_head.load(std::memory_order_acquire)) {
             // Initialize new step segment and load number of steps to execute
-            st.exec_segment = &segment_buffer[segment_buffer_tail];
+            st.exec_segment = &segment_buffer[tail & segment_mask];
             // Initialize step segment timing per step and load number of steps to execute.
             config->_stepping->setTimerPeriod(st.exec_segment->isrPeriod);
+            if (StepTrace::_active) {
+                StepTrace::set_period(st.exec_segment->isrPeriod);
+            }
+            shaper_period = st.exec_segment->isrPeriod;
             st.step_count = st.exec_segment->n_step;  // NOTE: Can sometimes be zero when moving slow.
             // If the new segment starts a new planner block, initialize stepper variables and counters.
             // NOTE: When the segment data index changes, this indicates a new planner block.
@@ -221,20 +486,46 @@ bool IRAM_ATTR Stepper::pulse_func() {
                 st.exec_block       = &st_block_buffer[st.exec_block_index];
                 // Initialize Bresenham line and distance counters
                 for (int axis = 0; axis < n_axis; axis++) {
-                    st.counter[axis] = st.exec_block->step_event_count >> 1;
+                    st.counter[axis] = st.exec_segment->step_event_count >> 1;
+                }
+                // The pixels of earlier raster blocks are no longer needed
+                if (int32_t(st.exec_block->raster_mark - plan_raster_released) > 0) {
+                    plan_raster_released = st.exec_block->raster_mark;
                 }
             }
 
-            st.dir_outbits = st.exec_block->direction_bits;
-            // Adjust Bresenham axis increment counters according to AMASS level.
-            for (int axis = 0; axis < n_axis; axis++) {
-                st.steps[axis] = st.exec_block->steps[axis] >> st.exec_segment->amass_level;
-            }
+            st.dir_outbits = st.exec_segment->direction_bits;
             // Set real-time spindle output as segment is loaded, just prior to the first step.
-            spindle->setSpeedfromISR(st.exec_segment->spindle_dev_speed);
+            if (st.exec_block->raster) {
+                // The segment speed is the power of a full power pixel
+                st.raster_dev_speed = st.exec_segment->spindle_dev_speed;
+                if (st.exec_block->raster_pixel < st.exec_block->raster_pixels) {
+                    raster_fire(st.exec_block);
+                }
+            } else {
+                spindle->setSpeedfromISR(st.exec_segment->spindle_dev_speed);
+            }
+        } else if (shaping() && shapers_busy()) {
+            // Segment buffer empty, but the shaped axes have not caught up with the commanded
+            // motion. Keep ticking until they have.
+            if (shaper_period != shaperDrainPeriod) {
+                shaper_period = shaperDrainPeriod;
+                config->_stepping->setTimerPeriod(shaperDrainPeriod);
+                if (StepTrace::_active) {
+                    StepTrace::set_period(shaperDrainPeriod);
+                }
+            }
+            st.step_outbits = 0;
+            shape_steps(st.dir_outbits);
+            timed_unstep();
+            return true;
         } else {
             // Segment buffer empty. Shutdown.
             stop_stepping();
+            if (!sys.step_control.endMotion) {
+                // Not the end of a hold or a system motion; prep_buffer() decides if it was an underrun
+                StepperStats::_drained = true;
+            }
             if (sys.state != State::Jog) {  // added to prevent ... jog after probing crash
                 // Ensure pwm is set properly upon completion of rate-controlled motion.
                 if (st.exec_block != NULL && st.exec_block->is_pwm_rate_adjusted) {
@@ -262,23 +553,32 @@ bool IRAM_ATTR Stepper::pulse_func() {
     // Reset step out bits.
     st.step_outbits = 0;
 
+    auto segment = st.exec_segment;
     for (int axis = 0; axis < n_axis; axis++) {
         // Execute step displacement profile by Bresenham line algorithm
-        st.counter[axis] += st.steps[axis];
-        if (st.counter[axis] > st.exec_block->step_event_count) {
+        st.counter[axis] += segment->steps[axis];
+        if (st.counter[axis] > segment->step_event_count) {
             set_bitnum(st.step_outbits, axis);
-            st.counter[axis] -= st.exec_block->step_event_count;
+            st.counter[axis] -= segment->step_event_count;
         }
     }
 
+    if (st.exec_block->raster && bitnum_is_true(st.step_outbits, st.exec_block->raster_axis)) {
+        raster_step(st.exec_block);
+    }
+
+    if (shaping()) {
+        shape_steps(segment->direction_bits);
+    }
+
     st.step_count--;  // Decrement step events count
     if (st.step_count == 0) {
         // Segment is complete. Discard current segment and advance segment indexing.
-        st.exec_segment     = NULL;
-        segment_buffer_tail = segment_buffer_tail >= (config->_stepping->_segments - 1) ? 0 : segment_buffer_tail + 1;
+        st.exec_segment = NULL;
+        segment_tail.store(segment_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
     }
 
-    config->_axes->unstep();
+    timed_unstep();
     return true;
 }
 
@@ -297,6 +597,10 @@ void Stepper::wake_up() {
     config->_stepping->startTimer();
 }
 
+bool Stepper::segments_pending() {
+    return segment_head.load(std::memory_order_relaxed) != segment_tail.load(std::memory_order_acquire);
+}
+
 void Stepper::go_idle() {
     awake = false;
     stop_stepping();
@@ -315,11 +619,20 @@ void Stepper::reset() {
     memset(&st, 0, sizeof(stepper_t));
     st.exec_segment     = NULL;
     pl_block            = NULL;  // Planner block pointer used by segment buffer
-    segment_buffer_tail = 0;
-    segment_buffer_head = 0;  // empty = tail
-    segment_next_head   = 1;
+    segment_tail.store(0);
+    segment_head.store(0);  // empty = tail
+    StepperStats::_drained = false;
     st.step_outbits     = 0;
     st.dir_outbits      = 0;  // Initialize direction bits to default.
+
+    shaper_clock    = 0;
+    shaped_dir_bits = 0;
+    auto axes       = config->_axes;
+    for (int axis = 0; axis < axes->_numberAxis; axis++) {
+        if (bitnum_is_true(Machine::Axes::shapedMask, axis)) {
+            axes->_axis[axis]->_shaper->reset();
+        }
+    }
     // TODO do we need to turn step pins off?
 }
 
@@ -374,6 +687,62 @@ static uint8_t next_block_index(uint8_t block_index) {
     return block_index == (config->_stepping->_segments - 1) ? 0 : block_index;
 }
 
+// Loads the steps of an arc segment ending mm_remaining from the end of the block into a new stepper
+// block. Returns the number of step events in the segment, which is zero if no axis has a whole
+// step to take, in which case no stepper block is used.
+static uint32_t prep_arc_segment(float mm_remaining) {
+    auto              n_axis = config->_axes->_numberAxis;
+    const plan_arc_t& arc    = pl_block->arc;
+    float             done   = 1.0f - mm_remaining / arc.length;
+    float             angle  = arc.start_angle + arc.angular_travel * done;
+    int32_t           delta[MAX_N_AXIS];
+    uint32_t          step_event_count = 0;
+
+    for (int idx = 0; idx < n_axis; idx++) {
+        int32_t total = bitnum_is_true(pl_block->direction_bits, idx) ? -int32_t(pl_block->steps[idx]) : int32_t(pl_block->steps[idx]);
+        int32_t target;
+        if (mm_remaining == 0.0f) {
+            target = total;  // Land exactly on the planner position
+        } else if (idx == arc.axis_0) {
+            target = lroundf(arc.radius * (cosf(angle) - prep.arc_cos_start) * config->_axes->_axis[idx]->_stepsPerMm);
+        } else if (idx == arc.axis_1) {
+            target = lroundf(arc.radius * (sinf(angle) - prep.arc_sin_start) * config->_axes->_axis[idx]->_stepsPerMm);
+        } else {
+            target = lroundf(total * done);
+        }
+        delta[idx]       = target - prep.arc_steps[idx];
+        step_event_count = MAX(step_event_count, uint32_t(labs(delta[idx])));
+    }
+    if (step_event_count == 0) {
+        return 0;
+    }
+
+    // The first segment uses the stepper block taken when the arc loaded, so an arc holds no
+    // more stepper blocks than it has segments queued.
+    bool is_pwm_rate_adjusted = st_prep_block->is_pwm_rate_adjusted;
+    if (prep.arc_slot_free) {
+        prep.arc_slot_free = false;
+    } else {
+        prep.st_block_index = next_block_index(prep.st_block_index);
+        st_prep_block       = &st_block_buffer[prep.st_block_index];
+    }
+    st_prep_block->is_pwm_rate_adjusted = is_pwm_rate_adjusted;
+    st_prep_block->direction_bits       = 0;
+    st_prep_block->raster               = nullptr;  // The slot may last have held a raster block
+    st_prep_block->raster_mark          = pl_block->raster_mark;
+    st_prep_block->raster_pixels        = 0;
+    st_prep_block->raster_pixel         = 0;
+    for (int idx = 0; idx < n_axis; idx++) {
+        st_prep_block->steps[idx] = uint32_t(labs(delta[idx])) << maxAmassLevel;
+        if (delta[idx] < 0) {
+            set_bitnum(st_prep_block->direction_bits, idx);
+        }
+        prep.arc_steps[idx] += delta[idx];
+    }
+    st_prep_block->step_event_count = step_event_count << maxAmassLevel;
+    return step_event_count;
+}
+
 /* Prepares step segment buffer. Continuously called from main program.
 
    The segment buffer is an intermediary buffer interface between the execution of steps
@@ -393,7 +762,12 @@ void Stepper::prep_buffer() {
         return;
     }
 
-    while (segment_buffer_tail != segment_next_head) {  // Check if we need to fill the buffer.
+    StepperStats::prep_check(awake,
+                             segment_head.load(std::memory_order_relaxed) - segment_tail.load(std::memory_order_acquire),
+                             pl_block != NULL || plan_get_current_block() != NULL);
+
+    // Check if we need to fill the buffer.
+    while (segment_head.load(std::memory_order_relaxed) - segment_tail.load(std::memory_order_acquire) < segment_capacity) {
         // Determine if we need to load a new planner block or if the block needs to be recomputed.
         if (pl_block == NULL) {
             // Query planner for a queued block
@@ -436,6 +810,20 @@ void Stepper::prep_buffer() {
                 // Initialize segment buffer data for generating the segments.
                 prep.steps_remaining  = (float)pl_block->step_event_count;
                 prep.step_per_mm      = prep.steps_remaining / pl_block->millimeters;
+                if (pl_block->is_arc) {
+                    // The steps of arc segments come from the arc itself. Size the minimum segment
+                    // by the finest resolution of the axes that move.
+                    prep.step_per_mm = 0.0f;
+                    for (idx = 0; idx < n_axis; idx++) {
+                        if (pl_block->steps[idx] || idx == pl_block->arc.axis_0 || idx == pl_block->arc.axis_1) {
+                            prep.step_per_mm = MAX(prep.step_per_mm, config->_axes->_axis[idx]->_stepsPerMm);
+                        }
+                        prep.arc_steps[idx] = 0;
+                    }
+                    prep.arc_cos_start = cosf(pl_block->arc.start_angle);
+                    prep.arc_sin_start = sinf(pl_block->arc.start_angle);
+                }
+                prep.arc_slot_free = pl_block->is_arc;
                 prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.step_per_mm;
                 prep.dt_remainder     = 0.0;  // Reset for new segment block
                 if ((sys.step_control.executeHold) || prep.recalculate_flag.decelOverride) {
@@ -447,6 +835,20 @@ void Stepper::prep_buffer() {
                     prep.current_speed = sqrtf(pl_block->entry_speed_sqr);
                 }
 
+                st_prep_block->raster        = pl_block->raster;
+                st_prep_block->raster_mark   = pl_block->raster_mark;
+                st_prep_block->raster_pixels = pl_block->raster_pixels;
+                st_prep_block->raster_events = pl_block->step_event_count;
+                st_prep_block->raster_error  = 0;
+                st_prep_block->raster_pixel  = 0;
+                st_prep_block->raster_axis   = 0;
+                for (idx = 0; idx < n_axis; idx++) {
+                    if (pl_block->steps[idx] == pl_block->step_event_count) {
+                        st_prep_block->raster_axis = idx;
+                        break;
+                    }
+                }
+
                 // prep.inv_rate is only used if is_pwm_rate_adjusted is true
                 st_prep_block->is_pwm_rate_adjusted = false;  // set default value
 
@@ -471,7 +873,11 @@ void Stepper::prep_buffer() {
                 // the planner block profile, enforcing a deceleration to zero speed.
                 prep.ramp_type = RAMP_DECEL;
                 // Compute decelerate distance relative to end of block.
-                float decel_dist = pl_block->millimeters - inv_2_accel * pl_block->entry_speed_sqr;
+                float stop_mm = inv_2_accel * pl_block->entry_speed_sqr;
+                if (pl_block->jerk > 0.0f && prep.current_accel != 0.0f) {
+                    stop_mm = scurve_stop_mm(pl_block);
+                }
+                float decel_dist = pl_block->millimeters - stop_mm;
                 if (decel_dist < 0.0) {
                     // Deceleration through entire planner block. End of feed hold is not in this block.
                     prep.exit_speed = sqrtf(pl_block->entry_speed_sqr - 2 * pl_block->acceleration * pl_block->millimeters);
@@ -543,11 +949,27 @@ void Stepper::prep_buffer() {
                 }
             }
 
+            prep.scurve = pl_block->jerk > 0.0f;
+            if (prep.scurve) {
+                if (!sys.step_control.executeHold) {
+                    scurve_fit_profile(pl_block);
+                }
+                if (prep.ramp_type == RAMP_ACCEL) {
+                    scurve_begin(pl_block->millimeters, prep.accelerate_until, prep.maximum_speed);
+                } else if (prep.ramp_type == RAMP_DECEL) {
+                    scurve_begin(pl_block->millimeters, prep.mm_complete, prep.exit_speed);
+                } else {
+                    prep.current_accel = 0.0f;  // Cruising, or an override deceleration that sets its own
+                }
+            } else {
+                prep.current_accel = 0.0f;
+            }
+
             sys.step_control.updateSpindleSpeed = true;  // Force update whenever updating block.
         }
 
         // Initialize new segment
-        volatile segment_t* prep_segment = &segment_buffer[segment_buffer_head];
+        segment_t* prep_segment = &segment_buffer[segment_head.load(std::memory_order_relaxed) & segment_mask];
 
         // Set new segment to point to the current segment data block.
         prep_segment->st_block_index = prep.st_block_index;
@@ -590,26 +1012,45 @@ void Stepper::prep_buffer() {
                         time_var           = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
                         prep.ramp_type     = RAMP_CRUISE;
                         prep.current_speed = prep.maximum_speed;
+                        prep.current_accel = 0.0f;
                     } else {  // Mid-deceleration override ramp.
                         prep.current_speed -= speed_var;
+                        prep.current_accel = -pl_block->acceleration;
                     }
                     break;
                 case RAMP_ACCEL:
                     // NOTE: Acceleration ramp only computes during first do-while loop.
-                    speed_var = pl_block->acceleration * time_var;
-                    mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
-                    if (mm_remaining < prep.accelerate_until) {  // End of acceleration ramp.
-                        // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
-                        mm_remaining = prep.accelerate_until;  // NOTE: 0.0 at EOB
-                        time_var     = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
-                        if (mm_remaining == prep.decelerate_after) {
-                            prep.ramp_type = RAMP_DECEL;
-                        } else {
-                            prep.ramp_type = RAMP_CRUISE;
+                    if (prep.scurve) {
+                        if (prep.ramp_elapsed + time_var < prep.ramp_duration) {
+                            mm_var = scurve_advance(prep.ramp_elapsed + time_var);
+                            if (mm_var > prep.accelerate_until) {  // Mid-acceleration ramp.
+                                mm_remaining = mm_var;
+                                prep.ramp_elapsed += time_var;
+                                break;
+                            }
                         }
-                        prep.current_speed = prep.maximum_speed;
-                    } else {  // Acceleration only.
-                        prep.current_speed += speed_var;
+                        time_var = prep.ramp_duration - prep.ramp_elapsed;
+                    } else {
+                        speed_var = pl_block->acceleration * time_var;
+                        mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
+                        if (mm_remaining >= prep.accelerate_until) {  // Acceleration only.
+                            prep.current_speed += speed_var;
+                            break;
+                        }
+                        time_var = 2.0f * (pl_block->millimeters - prep.accelerate_until) / (prep.current_speed + prep.maximum_speed);
+                    }
+                    // End of acceleration ramp.
+                    // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
+                    mm_remaining       = prep.accelerate_until;  // NOTE: 0.0 at EOB
+                    prep.current_speed = prep.maximum_speed;
+                    prep.current_accel = 0.0f;
+                    if (mm_remaining == prep.decelerate_after) {
+                        prep.ramp_type = RAMP_DECEL;
+                        if (prep.scurve) {
+                            scurve_begin(mm_remaining, prep.mm_complete, prep.exit_speed);
+                        }
+                    } else {
+                        prep.ramp_type = RAMP_CRUISE;
                     }
                     break;
                 case RAMP_CRUISE:
@@ -622,11 +1063,30 @@ void Stepper::prep_buffer() {
                         time_var       = (mm_remaining - prep.decelerate_after) / prep.maximum_speed;
                         mm_remaining   = prep.decelerate_after;  // NOTE: 0.0 at EOB
                         prep.ramp_type = RAMP_DECEL;
+                        if (prep.scurve) {
+                            scurve_begin(mm_remaining, prep.mm_complete, prep.exit_speed);
+                        }
                     } else {  // Cruising only.
                         mm_remaining = mm_var;
                     }
                     break;
                 default:  // case RAMP_DECEL:
+                    if (prep.scurve) {
+                        if (prep.ramp_elapsed + time_var < prep.ramp_duration) {
+                            mm_var = scurve_advance(prep.ramp_elapsed + time_var);
+                            if (mm_var > prep.mm_complete) {  // Mid-deceleration ramp.
+                                mm_remaining = mm_var;
+                                prep.ramp_elapsed += time_var;
+                                break;
+                            }
+                        }
+                        // End of block or end of forced-deceleration.
+                        time_var           = prep.ramp_duration - prep.ramp_elapsed;
+                        mm_remaining       = prep.mm_complete;
+                        prep.current_speed = prep.exit_speed;
+                        prep.current_accel = 0.0f;
+                        break;
+                    }
                     // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
                     speed_var = pl_block->acceleration * time_var;  // Used as delta speed (mm/min)
                     if (prep.current_speed > speed_var) {           // Check if at or below zero speed.
@@ -693,11 +1153,33 @@ void Stepper::prep_buffer() {
            high step counts can exceed the precision of floats, which can lead to lost steps.
            Fortunately, this scenario is highly unlikely and unrealistic in typical DIY CNC
            machines (i.e. exceeding 10 meters axis travel at 200 step/mm).
+           Arc blocks instead get a stepper block per segment, holding the steps to the point on
+           the arc where the segment ends.
         */
-        float step_dist_remaining    = prep.step_per_mm * mm_remaining;                       // Convert mm_remaining to steps
-        float n_steps_remaining      = ceilf(step_dist_remaining);                            // Round-up current steps remaining
-        float last_n_steps_remaining = ceilf(prep.steps_remaining);                           // Round-up last steps remaining
-        prep_segment->n_step         = uint16_t(last_n_steps_remaining - n_steps_remaining);  // Compute number of steps to execute.
+        float step_dist_remaining    = 0.0f;
+        float n_steps_remaining      = 0.0f;
+        float last_n_steps_remaining = 0.0f;
+        if (pl_block->is_arc) {
+            prep_segment->n_step = uint16_t(prep_arc_segment(mm_remaining));
+            if (prep_segment->n_step == 0 && !sys.step_control.executeHold) {
+                if (mm_remaining > prep.mm_complete) {
+                    // No axis has a whole step to take yet. Carry the time over to the next segment.
+                    pl_block->millimeters = mm_remaining;
+                    prep.dt_remainder += dt;
+                    continue;
+                }
+                // The previous segments already took all of the steps of the block.
+                pl_block = NULL;
+                plan_discard_current_block();
+                continue;
+            }
+            prep_segment->st_block_index = prep.st_block_index;
+        } else {
+            step_dist_remaining    = prep.step_per_mm * mm_remaining;                       // Convert mm_remaining to steps
+            n_steps_remaining      = ceilf(step_dist_remaining);                            // Round-up current steps remaining
+            last_n_steps_remaining = ceilf(prep.steps_remaining);                           // Round-up last steps remaining
+            prep_segment->n_step   = uint16_t(last_n_steps_remaining - n_steps_remaining);  // Compute number of steps to execute.
+        }
 
         // Bail if we are at the end of a feed hold and don't have a step to execute.
         if (prep_segment->n_step == 0) {
@@ -723,7 +1205,12 @@ void Stepper::prep_buffer() {
 
         dt += prep.dt_remainder;  // Apply previous segment partial step execute time
         // dt is in minutes so inv_rate is in minutes
-        float inv_rate = dt / (last_n_steps_remaining - step_dist_remaining);  // Compute adjusted step rate inverse
+        float inv_rate;
+        if (pl_block->is_arc) {
+            inv_rate = dt / prep_segment->n_step;  // Arc segments end on whole steps
+        } else {
+            inv_rate = dt / (last_n_steps_remaining - step_dist_remaining);  // Compute adjusted step rate inverse
+        }
 
         // Compute CPU cycles per step for the prepped segment.
         // fStepperTimer is in units of timerTicks/sec, so the dimensional analysis is
@@ -744,15 +1231,24 @@ void Stepper::prep_buffer() {
         // largest value that will fit in a uint16_t.
         prep_segment->isrPeriod = timerTicks > 0xffff ? 0xffff : timerTicks;
 
+        // Decode the Bresenham data for the AMASS level of the segment.
+        prep_segment->direction_bits   = st_prep_block->direction_bits;
+        prep_segment->step_event_count = st_prep_block->step_event_count;
+        for (int axis = 0; axis < config->_axes->_numberAxis; axis++) {
+            prep_segment->steps[axis] = st_prep_block->steps[axis] >> level;
+        }
+
         // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
-        auto lastseg        = segment_next_head;
-        segment_next_head   = segment_next_head >= (config->_stepping->_segments - 1) ? 0 : segment_next_head + 1;
-        segment_buffer_head = lastseg;
+        segment_head.store(segment_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 
         // Update the appropriate planner and segment data.
         pl_block->millimeters = mm_remaining;
-        prep.steps_remaining  = n_steps_remaining;
-        prep.dt_remainder     = (n_steps_remaining - step_dist_remaining) * inv_rate;
+        if (pl_block->is_arc) {
+            prep.dt_remainder = 0.0f;
+        } else {
+            prep.steps_remaining = n_steps_remaining;
+            prep.dt_remainder    = (n_steps_remaining - step_dist_remaining) * inv_rate;
+        }
         // Check for exit conditions and flag to load next planner block.
         if (mm_remaining == prep.mm_complete) {
             // End of planner block or forced-termination. No more distance to be executed.
@@ -45,5 +45,8 @@ namespace Stepper {
     // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
     float get_realtime_rate();
 
+    // True if the segment buffer holds segments that have not finished executing
+    bool segments_pending();
+
     extern uint32_t isr_count;
 }
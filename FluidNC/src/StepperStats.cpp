@@ -0,0 +1,60 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "StepperStats.h"
+
+#include "Logging.h"
+
+namespace StepperStats {
+    Cycles probes[N_PROBES];
+
+    volatile bool _drained  = false;
+    bool          _inStatus = false;
+
+    static uint32_t underrunCount = 0;
+    static uint32_t lowWater      = UINT32_MAX;
+
+    static const char* probeNames[N_PROBES] = { "pulse_func", "step", "unstep", "i2s_fill" };
+
+    void prep_check(bool running, uint32_t queued, bool pending) {
+        if (_drained) {
+            // The ISR stopped since the last call.  If there is still motion to prep, it
+            // stopped because the foreground did not keep up.
+            _drained = false;
+            if (pending) {
+                underrunCount++;
+            }
+        }
+        if (running && pending && queued < lowWater) {
+            lowWater = queued;
+        }
+    }
+
+    uint32_t underruns() { return underrunCount; }
+    uint32_t low_water() { return lowWater; }
+
+    void reset() {
+        // The ISR may update a probe while it is being cleared.  That can only skew
+        // the first sample, so it is not worth a critical section.
+        for (auto& probe : probes) {
+            probe = Cycles();
+        }
+        underrunCount = 0;
+        lowWater      = UINT32_MAX;
+        _drained      = false;
+    }
+
+    void report(Channel& out) {
+        for (int i = 0; i < N_PROBES; i++) {
+            auto& probe = probes[i];
+            if (probe.count) {
+                log_to(out,
+                       "[STEPPER:",
+                       probeNames[i] << " min:" << probe.min << " avg:" << probe.avg() << " max:" << probe.max
+                                     << " count:" << probe.count << " cycles");
+            } else {
+                log_to(out, "[STEPPER:", probeNames[i] << " not run");
+            }
+        }
+        log_to(out, "[STEPPER:", "underruns:" << underrunCount << " low_water:" << (lowWater == UINT32_MAX ? 0 : lowWater));
+    }
+}
@@ -0,0 +1,81 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  StepperStats.h - cycle budget of the step generation path
+
+  The stepper ISR and the I2S DMA refill are timed with the CPU cycle counter every
+  time they run, so the cost of a configuration can be read off a running machine
+  with $Stepper/Stats instead of with a logic analyzer.  Timing is always on; each
+  probe costs two reads of the cycle counter and a few compares.
+
+  The segment preparation side is watched too.  An underrun is counted when the ISR
+  runs out of segments while there is still planned motion, which makes the machine
+  stop and restart mid-job.  The low-water mark is the smallest number of queued
+  segments seen when prep_buffer() got to run with motion pending, so it shows how
+  close the foreground came to an underrun.
+*/
+
+#include "Driver/delay_usecs.h"  // getCpuTicks()
+
+#include <cstdint>
+
+class Channel;
+
+namespace StepperStats {
+    struct Cycles {
+        uint32_t min   = UINT32_MAX;
+        uint32_t max   = 0;
+        uint32_t count = 0;
+        uint64_t total = 0;
+
+        inline __attribute__((always_inline)) void add(uint32_t cycles) {
+            if (cycles < min) {
+                min = cycles;
+            }
+            if (cycles > max) {
+                max = cycles;
+            }
+            count++;
+            total += cycles;
+        }
+
+        uint32_t avg() const { return count ? uint32_t(total / count) : 0; }
+    };
+
+    enum Probe {
+        PulseFunc = 0,  // Stepper::pulse_func()
+        Step,           // Axes::step()
+        Unstep,         // Axes::unstep()
+        I2SFill,        // i2s_fillout_dma_buffer()
+        N_PROBES,
+    };
+
+    extern Cycles probes[N_PROBES];
+
+    // Start and stop a timed region.  The start value is a cycle count.  These are
+    // forced inline so that they land in IRAM with the ISR code that uses them.
+    inline __attribute__((always_inline)) int32_t start() { return getCpuTicks(); }
+    inline __attribute__((always_inline)) void stop(Probe probe, int32_t started) {
+        probes[probe].add(uint32_t(getCpuTicks() - started));
+    }
+
+    // Set by the stepper ISR when it stops because the segment buffer is empty
+    extern volatile bool _drained;
+
+    // Called from Stepper::prep_buffer().  queued is the number of segments in the
+    // buffer and pending is true if there is planned motion that is not yet prepped.
+    void prep_check(bool running, uint32_t queued, bool pending);
+
+    uint32_t underruns();
+    uint32_t low_water();  // UINT32_MAX if motion has not been seen since the last reset
+
+    // Include a summary in ? status reports
+    extern bool _inStatus;
+
+    void reset();
+
+    // Lists every probe and the segment counters on out
+    void report(Channel& out);
+}
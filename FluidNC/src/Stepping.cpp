@@ -14,6 +14,7 @@ namespace Machine {
                              { Stepping::RMT, "RMT" },
                              { Stepping::I2S_STATIC, "I2S_static" },
                              { Stepping::I2S_STREAM, "I2S_stream" },
+                             { Stepping::BATCHED, "Batched" },
                              EnumItem(Stepping::RMT) };
 
     void Stepping::init() {
@@ -59,7 +60,7 @@ namespace Machine {
     }
     // Called only from Axes::unstep()
     void IRAM_ATTR Stepping::waitPulse() {
-        if (_engine == I2S_STATIC || _engine == TIMED) {
+        if (_engine == I2S_STATIC || _engine == TIMED || _engine == BATCHED) {
             spinUntil(_stepPulseEndTime);
         }
     }
@@ -76,7 +77,7 @@ namespace Machine {
                 // Commit the pin changes to the hardware immediately
                 i2s_out_push();
                 delay_us(_directionDelayUsecs);
-            } else if (_engine == stepper_id_t::TIMED) {
+            } else if (_engine == stepper_id_t::TIMED || _engine == stepper_id_t::BATCHED) {
                 // If we are using RMT, we can't delay here.
                 delay_us(_directionDelayUsecs);
             }
@@ -92,7 +93,7 @@ namespace Machine {
         } else if (_engine == stepper_id_t::I2S_STATIC) {
             i2s_out_push();
             _stepPulseEndTime = usToEndTicks(_pulseUsecs);
-        } else if (_engine == stepper_id_t::TIMED) {
+        } else if (_engine == stepper_id_t::TIMED || _engine == stepper_id_t::BATCHED) {
             _stepPulseEndTime = usToEndTicks(_pulseUsecs);
         }
     }
@@ -139,7 +140,7 @@ namespace Machine {
         handler.item("pulse_us", _pulseUsecs, 0, 30);
         handler.item("dir_delay_us", _directionDelayUsecs, 0, 10);
         handler.item("disable_delay_us", _disableDelayUsecs, 0, 10);
-        handler.item("segments", _segments, 6, 20);
+        handler.item("segments", _segments, 6, 128);
     }
 
     void Stepping::afterParse() {
@@ -164,6 +165,7 @@ namespace Machine {
             case stepper_id_t::RMT:
                 return 1000000 / (2 * _pulseUsecs + _directionDelayUsecs);
             case stepper_id_t::TIMED:
+            case stepper_id_t::BATCHED:
             default:
                 return 80000;  // based on testing
         }
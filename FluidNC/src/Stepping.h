@@ -27,6 +27,7 @@ namespace Machine {
             RMT,
             I2S_STATIC,
             I2S_STREAM,
+            BATCHED,  // Like TIMED, but all GPIO step pins change with one register store
         };
 
         Stepping() = default;
@@ -36,7 +37,8 @@ namespace Machine {
         // fixed time defined by ACCELERATION_TICKS_PER_SECOND. They are computed such that the planner
         // block velocity profile is traced exactly. The size of this buffer governs how much step
         // execution lead time there is for other processes to run.  The latency for a feedhold or other
-        // override is roughly 10 ms times _segments.
+        // override is roughly 10 ms times _segments.  The ring that holds the segments is rounded up to
+        // a power of two, so the stepper ISR can index it with a mask.
 
         size_t _segments = 12;
 
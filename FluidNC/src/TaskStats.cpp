@@ -0,0 +1,234 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#include "TaskStats.h"
+
+#include "Logging.h"
+
+#include <Esp.h>        // ESP.getFreeHeap()
+#include <esp_timer.h>  // esp_timer_get_time()
+#include <atomic>
+#include <cstring>
+
+#ifdef ESP32
+#    include <esp_freertos_hooks.h>  // esp_register_freertos_tick_hook_for_cpu()
+#endif
+
+namespace TaskStats {
+    struct Load {
+        const char*           name;
+        TaskHandle_t          handle = nullptr;
+        std::atomic<int64_t>  wokeAt { 0 };  // Start of the busy time not yet in busyUs, or 0 while blocked
+        std::atomic<uint64_t> busyUs { 0 };
+        std::atomic<uint32_t> wakes { 0 };
+
+        // The totals at the previous report
+        uint64_t lastBusyUs = 0;
+        uint32_t lastWakes  = 0;
+
+        Load(const char* n) : name(n) {}
+    };
+
+    static Load loads[N_TASKS] = { { "poller" }, { "output" }, { "main" }, { "i2s" }, { "vfd" }, { "limits" } };
+
+    static int64_t lastReport = 0;
+
+#ifdef ESP32
+    // The load of each core is sampled by its tick interrupt, which finds either the idle
+    // task of the core running or something else.  The share of the ticks that found
+    // something else is the load of the core.  This covers every task on the core, ours or
+    // not, does not need FreeRTOS run time stats, and leaves the idle task free to let the
+    // core sleep until the next interrupt.
+    struct Core {
+        TaskHandle_t          idle = nullptr;
+        std::atomic<uint32_t> ticks { 0 };
+        std::atomic<uint32_t> idleTicks { 0 };
+
+        // The totals at the previous report
+        uint32_t lastTicks     = 0;
+        uint32_t lastIdleTicks = 0;
+    };
+    static Core cores[portNUM_PROCESSORS];
+
+    template <int core>
+    static void IRAM_ATTR tick_hook() {
+        auto& c = cores[core];
+        c.ticks.fetch_add(1, std::memory_order_relaxed);
+        if (xTaskGetCurrentTaskHandleForCPU(core) == c.idle) {
+            c.idleTicks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void start_cores() {
+        static std::atomic<bool> started { false };
+        if (!started.exchange(true)) {
+            cores[0].idle = xTaskGetIdleTaskHandleForCPU(0);
+            esp_register_freertos_tick_hook_for_cpu(tick_hook<0>, 0);
+#    if portNUM_PROCESSORS > 1
+            cores[1].idle = xTaskGetIdleTaskHandleForCPU(1);
+            esp_register_freertos_tick_hook_for_cpu(tick_hook<1>, 1);
+#    endif
+        }
+    }
+
+    // Lists the load of each core on out, or only starts a new window if out is nullptr
+    static void report_cores(Channel* out) {
+        for (int i = 0; i < portNUM_PROCESSORS; i++) {
+            auto&    c     = cores[i];
+            uint32_t ticks = c.ticks;
+            uint32_t idle  = c.idleTicks;
+            if (out && ticks != c.lastTicks) {
+                float load = 100.0f - (idle - c.lastIdleTicks) * 100.0f / (ticks - c.lastTicks);
+                log_to(*out, "[TASKS:", "core" << i << " load:" << setprecision(1) << load << "%");
+            }
+            c.lastTicks     = ticks;
+            c.lastIdleTicks = idle;
+        }
+    }
+#else
+    static void start_cores() {}
+    static void report_cores(Channel* out) {}
+#endif
+
+    void start(Task task) {
+        start_cores();
+        auto& load  = loads[task];
+        load.handle = xTaskGetCurrentTaskHandle();
+        load.wokeAt = esp_timer_get_time();
+    }
+
+    void sleep(Task task) {
+        auto&   load = loads[task];
+        int64_t from = load.wokeAt.exchange(0);
+        if (from) {
+            load.busyUs += esp_timer_get_time() - from;
+        }
+    }
+
+    // Adds the busy time of a task that is awake up to now, so a task that seldom or never
+    // blocks is not shown as idle.  The exchange keeps this and sleep() from counting the
+    // same time twice.
+    static void charge(Load& load, int64_t now) {
+        int64_t from = load.wokeAt;
+        while (from && from < now && !load.wokeAt.compare_exchange_weak(from, now)) {}
+        if (from && from < now) {
+            load.busyUs += now - from;
+        }
+    }
+
+    void wake(Task task) {
+        auto& load  = loads[task];
+        load.wokeAt = esp_timer_get_time();
+        ++load.wakes;
+    }
+
+    bool wait(Task task, TickType_t timeout) {
+        sleep(task);
+        bool notified = ulTaskNotifyTake(pdTRUE, timeout) != 0;
+        wake(task);
+        return notified;
+    }
+
+    void notify(Task task) {
+        auto handle = loads[task].handle;
+        if (handle) {
+            xTaskNotifyGive(handle);
+        }
+    }
+
+    void IRAM_ATTR notify_from_ISR(Task task) {
+        auto handle = loads[task].handle;
+        if (handle) {
+            vTaskNotifyGiveFromISR(handle, NULL);
+        }
+    }
+
+    // Tasks that are not ours, by their FreeRTOS names
+    static const char* otherTasks[] = { "wifi", "tiT", "btController", "loopTask" };
+
+#if configUSE_TRACE_FACILITY
+    static const size_t nOtherTasks = sizeof(otherTasks) / sizeof(otherTasks[0]);
+    static const int    maxTasks    = 32;
+
+    // The FreeRTOS run time counters at the previous report, for the tasks above
+    static uint32_t lastRunTime[nOtherTasks] = {};
+    static uint32_t lastTotalRunTime         = 0;
+
+    // Lists the tasks above on out, or only starts a new window if out is nullptr
+    static void report_others(Channel* out) {
+        static TaskStatus_t status[maxTasks];
+        uint32_t            totalRunTime = 0;
+        UBaseType_t         n            = uxTaskGetSystemState(status, maxTasks, &totalRunTime);
+        uint32_t            window       = totalRunTime - lastTotalRunTime;
+        lastTotalRunTime                 = totalRunTime;
+
+        for (size_t i = 0; i < nOtherTasks; i++) {
+            for (UBaseType_t j = 0; j < n; j++) {
+                auto& task = status[j];
+                if (strcmp(task.pcTaskName, otherTasks[i])) {
+                    continue;
+                }
+#    if configGENERATE_RUN_TIME_STATS
+                uint32_t runTime = task.ulRunTimeCounter - lastRunTime[i];
+                lastRunTime[i]   = task.ulRunTimeCounter;
+#    endif
+                if (!out) {
+                    continue;
+                }
+                LogStream msg(*out, "[TASKS:");
+                msg << otherTasks[i];
+#    if configGENERATE_RUN_TIME_STATS
+                if (window) {
+                    msg << " cpu:" << setprecision(1) << runTime * 100.0f / window << "%";
+                }
+#    endif
+                msg << " stack_free:" << task.usStackHighWaterMark;
+            }
+        }
+    }
+#else
+    static void report_others(Channel* out) {}
+#endif
+
+    void report(Channel& out, uint32_t windowMs) {
+        if (windowMs) {
+            // Start a new window and let it run
+            int64_t now = esp_timer_get_time();
+            for (auto& load : loads) {
+                charge(load, now);
+                load.lastBusyUs = load.busyUs;
+                load.lastWakes  = load.wakes;
+            }
+            lastReport = now;
+            report_cores(nullptr);
+            report_others(nullptr);
+
+            Blocked blocked(Main);
+            vTaskDelay(windowMs / portTICK_PERIOD_MS);
+        }
+
+        int64_t now    = esp_timer_get_time();
+        int64_t window = now - lastReport;
+        lastReport     = now;
+
+        log_to(out,
+               "[TASKS:",
+               "window:" << setprecision(2) << window / 1e6f << "s heap_free:" << ESP.getFreeHeap() << " heap_low:" << ESP.getMinFreeHeap()
+                         << " largest_block:" << ESP.getMaxAllocHeap());
+        report_cores(&out);
+        for (auto& load : loads) {
+            charge(load, now);
+            uint64_t busy  = load.busyUs;
+            uint32_t wakes = load.wakes;
+            if (load.handle) {
+                float share = window > 0 ? (busy - load.lastBusyUs) * 100.0f / window : 0.0f;
+                log_to(out,
+                       "[TASKS:",
+                       load.name << " cpu:" << setprecision(1) << share << "% wakes:" << (wakes - load.lastWakes)
+                                 << " stack_free:" << uxTaskGetStackHighWaterMark(load.handle));
+            }
+            load.lastBusyUs = busy;
+            load.lastWakes  = wakes;
+        }
+        report_others(&out);
+    }
+}
@@ -0,0 +1,70 @@
+// Use of this source code is governed by a GPLv3 license that can be found in the LICENSE file.
+
+#pragma once
+
+/*
+  TaskStats.h - how busy the FluidNC tasks are, and how close they are to their limits
+
+  The poller, the output task and the main loop sleep until they have work to do,
+  instead of spinning with vTaskDelay(0).  Each of them does its sleeping through
+  wait(), which blocks on the task notification.  Anything that hands a loop some
+  work calls notify() to wake it before its timeout.
+
+  The time that a task spends blocked is marked with sleep() and wake(), directly
+  or through a Blocked object, and the rest of its time is counted as busy, up to
+  the moment of the report for a task that is awake, so the main loop shows as
+  busy while it yields with vTaskDelay(0) during motion.  wait()
+  does that for the loops above, and the I2S, VFD and limit tasks mark their own
+  blocking calls, so $Sys/Tasks can show the share of a core that each of them
+  uses, along with their stack and the heap.  Tasks that are not ours, like the
+  WiFi ones, are listed from FreeRTOS, with their CPU share only if FreeRTOS was
+  built to keep run time statistics.  The load of each core is sampled from its
+  tick interrupt, so a saturated core shows up either way.
+*/
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdint>
+
+class Channel;
+
+namespace TaskStats {
+    enum Task {
+        Poller = 0,  // polling_loop()
+        Output,      // output_loop()
+        Main,        // protocol_main_loop()
+        I2S,         // i2sOutTask()
+        Vfd,         // VFD::vfd_cmd_task()
+        Limits,      // limitCheckTask()
+        N_TASKS,
+    };
+
+    // Called by a task when it starts, so notify() and the report can find it
+    void start(Task task);
+
+    // Bracket a call that blocks the task
+    void sleep(Task task);
+    void wake(Task task);
+
+    class Blocked {
+        Task _task;
+
+    public:
+        Blocked(Task task) : _task(task) { sleep(task); }
+        ~Blocked() { wake(_task); }
+    };
+
+    // Sleeps until the task is notified or timeout ticks pass.  Returns true if it
+    // was notified.
+    bool wait(Task task, TickType_t timeout);
+
+    // Wakes the task if it is in wait(), or keeps its next wait() from sleeping
+    void notify(Task task);
+    void notify_from_ISR(Task task);
+
+    // Lists the share of the time since the previous report that each task was
+    // busy, their stack high-water marks and the state of the heap.  If windowMs
+    // is not zero, the shares are measured over the next windowMs instead.
+    void report(Channel& out, uint32_t windowMs = 0);
+}
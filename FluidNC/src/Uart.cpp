@@ -77,10 +77,20 @@ size_t Uart::write(const uint8_t* buffer, size_t length) {
 // }
 
 size_t Uart::timedReadBytes(char* buffer, size_t len, TickType_t timeout) {
+    if (!len) {
+        return 0;
+    }
+    size_t pushed = 0;
+    if (_pushback != -1) {
+        *buffer++ = _pushback;
+        _pushback = -1;
+        --len;
+        pushed = 1;
+    }
     int res = uart_read_bytes(uart_port_t(_uart_num), buffer, len, timeout);
     // If res < 0, no bytes were read
 
-    return res < 0 ? 0 : res;
+    return pushed + (res < 0 ? 0 : res);
 }
 
 bool Uart::setHalfDuplex() {
@@ -7,6 +7,7 @@
 
 UartChannel::UartChannel(bool addCR) : Channel("uart", addCR) {
     _lineedit = new Lineedit(this, _line, Channel::maxLine - 1);
+    enableBulkInput();
 }
 
 void UartChannel::init() {
@@ -55,11 +56,12 @@ size_t UartChannel::write(const uint8_t* buffer, size_t length) {
 }
 
 int UartChannel::available() {
-    return _uart->available();
+    return buffered() + _uart->available();
 }
 
 int UartChannel::peek() {
-    return _uart->peek();
+    int ch = peekBuffered();
+    return ch < 0 ? _uart->peek() : ch;
 }
 
 int UartChannel::rx_buffer_available() {
@@ -70,6 +72,14 @@ bool UartChannel::realtimeOkay(char c) {
     return _lineedit->realtime(c);
 }
 
+size_t UartChannel::readRx(char* buffer, size_t len) {
+    return _uart->timedReadBytes(buffer, len, 0);
+}
+
+void UartChannel::addPlain(const char* s, size_t len) {
+    _lineedit->add(s, len);
+}
+
 bool UartChannel::lineComplete(char* line, char c) {
     if (_lineedit->step(c)) {
         _linelen        = _lineedit->finish();
@@ -91,7 +101,8 @@ Channel* UartChannel::pollLine(char* line) {
 }
 
 int UartChannel::read() {
-    return _uart->read();
+    int ch = takeBuffered();
+    return ch < 0 ? _uart->read() : ch;
 }
 
 void UartChannel::flushRx() {
@@ -100,13 +111,14 @@ void UartChannel::flushRx() {
 }
 
 size_t UartChannel::timedReadBytes(char* buffer, size_t length, TickType_t timeout) {
-    // It is likely that _queue will be empty because timedReadBytes() is only
-    // used in situations where the UART is not receiving GCode commands
+    // It is likely that nothing will be buffered because timedReadBytes() is
+    // only used in situations where the UART is not receiving GCode commands
     // and Grbl realtime characters.
     size_t remlen = length;
-    while (remlen && _queue.size()) {
-        *buffer++ = _queue.front();
-        _queue.pop();
+    int    ch;
+    while (remlen && (ch = takeBuffered()) >= 0) {
+        *buffer++ = ch;
+        --remlen;
     }
 
     int res = _uart->timedReadBytes(buffer, remlen, timeout);
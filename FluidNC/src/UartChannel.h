@@ -14,6 +14,10 @@ private:
 
     int _uart_num = 0;
 
+protected:
+    size_t readRx(char* buffer, size_t len) override;
+    void   addPlain(const char* s, size_t len) override;
+
 public:
     UartChannel(bool addCR = false);
 
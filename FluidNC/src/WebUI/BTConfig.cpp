@@ -6,8 +6,9 @@
 #    include "BTConfig.h"
 
 #    include "../Machine/MachineConfig.h"
-#    include "../Report.h"  // CLIENT_*
-#    include "Commands.h"   // COMMANDS
+#    include "../Report.h"     // CLIENT_*
+#    include "../TaskStats.h"  // TaskStats::notify()
+#    include "Commands.h"      // COMMANDS
 #    include "WebSettings.h"
 
 #    include <cstdint>
@@ -68,6 +69,9 @@ namespace WebUI {
                 log_info("BT Disconnected");
                 inst->_btclient = "";
                 break;
+            case ESP_SPP_DATA_IND_EVT:  //Data received
+                TaskStats::notify(TaskStats::Poller);
+                break;
             default:
                 break;
         }
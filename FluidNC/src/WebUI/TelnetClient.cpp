@@ -10,9 +10,12 @@
 #    include "WifiServices.h"
 
 #    include <WiFi.h>
+#    include <algorithm>
 
 namespace WebUI {
-    TelnetClient::TelnetClient(WiFiClient* wifiClient) : Channel("telnet"), _wifiClient(wifiClient) {}
+    TelnetClient::TelnetClient(WiFiClient* wifiClient) : Channel("telnet"), _wifiClient(wifiClient) {
+        enableBulkInput();
+    }
 
     void TelnetClient::handle() {}
 
@@ -56,18 +59,31 @@ namespace WebUI {
         return length;
     }
 
-    int TelnetClient::peek(void) { return _wifiClient->peek(); }
+    int TelnetClient::peek(void) {
+        int ch = peekBuffered();
+        return ch < 0 ? _wifiClient->peek() : ch;
+    }
 
-    int TelnetClient::available() { return _wifiClient->available(); }
+    int TelnetClient::available() { return buffered() + _wifiClient->available(); }
 
     int TelnetClient::rx_buffer_available() { return WIFI_CLIENT_READ_BUFFER_SIZE - available(); }
 
     int TelnetClient::read(void) {
+        int ch = takeBuffered();
+        if (ch >= 0) {
+            return ch;
+        }
+        char c;
+        return readRx(&c, 1) ? uint8_t(c) : -1;
+    }
+
+    size_t TelnetClient::readRx(char* buffer, size_t len) {
         if (_state == -1) {
-            return -1;
+            return 0;
         }
-        auto ret = _wifiClient->read();
-        if (ret < 0) {
+        int avail = _wifiClient->available();
+        int ret   = avail > 0 ? _wifiClient->read((uint8_t*)buffer, std::min(len, size_t(avail))) : -1;
+        if (ret <= 0) {
             // calling _wifiClient->connected() is expensive when the client is
             // connected because it calls recv() to double check, so we check
             // infrequently, only after quite a few reads have returned no data
@@ -79,7 +95,7 @@ namespace WebUI {
             // Reset the counter if we have data
             _state = 0;
         }
-        return ret;
+        return ret < 0 ? 0 : ret;
     }
 
     TelnetClient::~TelnetClient() { delete _wifiClient; }
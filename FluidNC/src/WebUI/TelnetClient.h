@@ -25,6 +25,9 @@ namespace WebUI {
 
         int _state = 0;
 
+    protected:
+        size_t readRx(char* buffer, size_t len) override;
+
     public:
         TelnetClient(WiFiClient* wifiClient);
 
@@ -5,6 +5,7 @@
 #include "TelnetClient.h"
 #include "TelnetServer.h"
 #include "WebSettings.h"
+#include "../Protocol.h"  // protocol_has_lines_from
 
 #ifdef ENABLE_WIFI
 
@@ -72,10 +73,14 @@ namespace WebUI {
         }
 
         while (_disconnected.size()) {
-            log_debug("Telnet client disconnected");
             TelnetClient* client = _disconnected.front();
-            _disconnected.pop();
             allChannels.deregistration(client);
+            if (protocol_has_lines_from(client)) {
+                // The main loop still has lines from it; delete it on a later pass
+                break;
+            }
+            log_debug("Telnet client disconnected");
+            _disconnected.pop();
             delete client;
         }
 
@@ -3,6 +3,9 @@
 
 #include "lineedit.h"
 
+#include <algorithm>
+#include <cstring>
+
 Lineedit::Lineedit(Print* _out, char* line, int linelen) : out(_out), needs_reecho(false), startaddr(line), maxaddr(line + linelen) {
     restart();
 }
@@ -456,6 +459,21 @@ bool Lineedit::realtime(int c) {
     return true;
 }
 
+// Adds printable characters, the same as step() on each of them.
+// Outside of editing mode that is just a copy.
+void Lineedit::add(const char* s, int len) {
+    if (editing) {
+        while (len--) {
+            step(*s++);
+        }
+        return;
+    }
+    int n = std::min(len, int(maxaddr - thisaddr));
+    memcpy(thisaddr, s, n);
+    thisaddr += n;
+    endaddr = thisaddr;
+}
+
 // Returns true when the line is complete
 bool Lineedit::step(int c) {
     // Regardless of editing mode, ^L turns off editing/echoing
@@ -86,5 +86,6 @@ public:
     void start(char* addr, int count);
     int  finish();
     bool step(int c);
+    void add(const char* s, int len);
     bool realtime(int c);
 };
@@ -0,0 +1,78 @@
+#include "../TestFramework.h"
+
+#ifndef ESP32
+
+#    include <src/Channel.h>
+
+#    include <string>
+#    include <vector>
+
+// Feeds text to Channel::pollLine() through readRx(), in pieces of every size, and
+// checks that the lines come out the same as they went in.  The channel does not
+// take realtime characters, so ? ~ and ! stop the word scan but end up in the line.
+
+namespace ChannelTest {
+    class BulkFeed : public Channel {
+        std::string _input;
+        size_t      _pos   = 0;
+        size_t      _piece = 1;
+
+    protected:
+        size_t readRx(char* buffer, size_t len) override {
+            size_t n = std::min({ len, _piece, _input.size() - _pos });
+            memcpy(buffer, _input.data() + _pos, n);
+            _pos += n;
+            return n;
+        }
+
+    public:
+        BulkFeed(const std::string& input, size_t piece) : Channel("bulk"), _input(input), _piece(piece) { enableBulkInput(); }
+
+        bool   realtimeOkay(char c) override { return false; }
+        size_t write(uint8_t c) override { return 1; }
+        void   flush() override {}
+        int    read() override { return takeBuffered(); }
+        bool   done() { return _pos == _input.size() && !buffered(); }
+    };
+
+    static std::vector<std::string> feed(const std::string& input, size_t piece, bool busy) {
+        BulkFeed                 channel(input, piece);
+        std::vector<std::string> lines;
+        char                     line[Channel::maxLine];
+        for (int polls = 0; polls < 10000 && !channel.done(); polls++) {
+            // While the main loop is busy, input is only scanned for realtime characters
+            if (busy && (polls % 3) == 0) {
+                channel.pollLine(nullptr);
+            } else if (channel.pollLine(line)) {
+                lines.push_back(line);
+            }
+        }
+        return lines;
+    }
+
+    Test(Channel, BulkInput) {
+        std::string              longLine(300, 'X');
+        std::vector<std::string> expected = { "G1 X1.5 Y-2",
+                                              "",
+                                              "g0z3",
+                                              "$Report/Interval=100 ?",
+                                              "(comment ~ with ! marks)",
+                                              "M3 S1000",
+                                              longLine.substr(0, Channel::maxLine - 1),
+                                              "N12345 G1 X0.0001 Y99999.9999 F1500" };
+        std::string input = "G1 X1.5 Y-2\n\r\ng0z3\r$Report/Interval=100 ?\n(comment ~ with ! marks)\r\nM3 S1000\n" + longLine +
+                            "\nN12345 G1 X0.0001 Y99999.9999 F1500\n";
+
+        for (size_t piece = 1; piece <= 300; piece += (piece < 12) ? 1 : 37) {
+            for (bool busy : { false, true }) {
+                auto lines = feed(input, piece, busy);
+                if (lines != expected) {
+                    Debug("BulkInput: %u lines with pieces of %u", unsigned(lines.size()), unsigned(piece));
+                }
+                Assert(lines == expected, "Lines differ from the input");
+            }
+        }
+    }
+}
+
+#endif
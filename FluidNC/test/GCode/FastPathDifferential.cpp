@@ -0,0 +1,170 @@
+#include "../TestFramework.h"
+
+#ifndef ESP32
+
+#    include "../Motion/MotionPipeline.h"
+
+#    include <cstdio>
+#    include <cstdlib>
+
+// Runs src/tests/parser.nc, the parser exercise that produced src/tests/parser-result.txt,
+// through gc_execute_line() with gcode_fast_path off and then on, and requires the same
+// result for every line: the status, and the parser state that the line leaves behind.
+// The file is followed by modal G1 lines that the fast path takes, mixed with lines it
+// must leave to the full parser, under the modes that change how the words are read.
+// Everything runs in check mode, as with $C, so M0 does not pause and nothing moves.
+//
+// parser-result.txt is a capture from a real machine, including its boot and network
+// messages, so it is not compared directly.  To get a transcript in the same ok/error
+// form to diff against it, set FLUIDNC_PARSER_RESULT_OUT to a file name.
+
+namespace Pipeline {
+    static const char* modalLines[] = {
+        "G21 G90 G54 G17 G94 G1 X0 Y0 Z0 F1000",
+        "X1",
+        "Y2 F1500",
+        "N10 X3 Y3 Z-1",
+        "x4.5y-2",
+        "X5 (comment) Y2 ; rest of line",
+        "S100 X5",
+        "X6 S-1",
+        "X7 X8",
+        "X9 F0",
+        "N99999999 X1",
+        "X1 I1",
+        "X2 T1",
+        "G92 X10",
+        "X11 Y11",
+        "G92.1",
+        "G10 L2 P1 X5",
+        "X1",
+        "G91",
+        "X1 Y1",
+        "X-2 F200",
+        "G90 G20",
+        "X1 Y1",
+        "Z0.1 F10",
+        "G21 G43.1 Z2",
+        "Z1",
+        "G49",
+        "Z1",
+        "M3 S200",
+        "X2 S300",
+        "Y2",
+        "M5",
+        "G0 X0",
+        "X1",
+        "G1 X2",
+        "G93 X1 F10",
+        "X2 F20",
+        "G94 F100",
+        "X3",
+        "G55",
+        "X1 Y1",
+        "G54 X2",
+    };
+
+    static std::string parserState() {
+        char buf[256];
+        snprintf(buf,
+                 sizeof(buf),
+                 "[GC:%d %d %d %d %d %d %d|%.4f,%.4f,%.4f|F%.4f S%.4f N%d|G92:%.4f,%.4f,%.4f TLO:%.4f]",
+                 int(gc_state.modal.motion),
+                 int(gc_state.modal.feed_rate),
+                 int(gc_state.modal.units),
+                 int(gc_state.modal.distance),
+                 int(gc_state.modal.plane_select),
+                 int(gc_state.modal.coord_select),
+                 int(gc_state.modal.spindle),
+                 gc_state.position[X_AXIS],
+                 gc_state.position[Y_AXIS],
+                 gc_state.position[Z_AXIS],
+                 gc_state.feed_rate,
+                 gc_state.spindle_speed,
+                 int(gc_state.line_number),
+                 gc_state.coord_offset[X_AXIS],
+                 gc_state.coord_offset[Y_AXIS],
+                 gc_state.coord_offset[Z_AXIS],
+                 gc_state.tool_length_offset);
+        return buf;
+    }
+
+    // Returns one transcript line per G-code line.  $ commands and realtime
+    // characters in the file are not G-code and are skipped.
+    static std::vector<std::string> runParser(const std::vector<std::string>& program, bool fastPath) {
+        config->_gcodeFastPath = fastPath;
+        float zeros[MAX_N_AXIS] = {};
+        for (CoordIndex idx = CoordIndex::Begin; idx < CoordIndex::End; ++idx) {
+            coords[idx]->set(zeros);
+        }
+        MotionPipeline::reset();
+        sys.state = State::CheckMode;
+
+        std::vector<std::string> transcript;
+        char                     buf[Channel::maxLine];
+        for (auto& line : program) {
+            if (line.empty() || line[0] == '$' || line[0] == '?' || line[0] == '~' || line[0] == '!') {
+                continue;
+            }
+            strncpy(buf, line.c_str(), sizeof(buf) - 1);
+            buf[sizeof(buf) - 1] = '\0';
+            Error result         = gc_execute_line(buf);
+            char  status[16];
+            if (result == Error::Ok) {
+                snprintf(status, sizeof(status), "ok");
+            } else {
+                snprintf(status, sizeof(status), "error:%d", int(result));
+            }
+            transcript.push_back(line + "\n" + status + " " + parserState());
+        }
+
+        sys.state              = State::Idle;
+        config->_gcodeFastPath = false;
+        MotionPipeline::reset();
+        return transcript;
+    }
+
+    Test(Parser, FastPathDifferential) {
+        Assert(MotionPipeline::init(), "Machine configuration failed to load");
+
+        const char*              filename = getenv("FLUIDNC_PARSER_TEST");
+        std::vector<std::string> program  = MotionPipeline::readLines(filename ? filename : "FluidNC/src/tests/parser.nc");
+        Assert(program.size() > 0, "Cannot read parser.nc");
+        program.insert(program.end(), std::begin(modalLines), std::end(modalLines));
+
+        gc_fast_path_lines = 0;
+        gc_full_path_lines = 0;
+        auto full          = runParser(program, false);
+        Assert(gc_fast_path_lines == 0, "Fast path ran while disabled");
+
+        gc_fast_path_lines = 0;
+        gc_full_path_lines = 0;
+        auto fast          = runParser(program, true);
+        Debug("FastPathDifferential: %u lines, %u fast, %u full",
+              unsigned(fast.size()),
+              unsigned(gc_fast_path_lines),
+              unsigned(gc_full_path_lines));
+
+        const char* out = getenv("FLUIDNC_PARSER_RESULT_OUT");
+        if (out) {
+            FILE* file = fopen(out, "w");
+            Assert(file, "Cannot write the parser transcript");
+            for (auto& entry : full) {
+                fprintf(file, "%s\n", entry.c_str());
+            }
+            fclose(file);
+        }
+
+        Assert(full.size() == fast.size(), "Different number of lines");
+        for (size_t i = 0; i < full.size(); i++) {
+            if (full[i] != fast[i]) {
+                Debug("Full path: %s", full[i].c_str());
+                Debug("Fast path: %s", fast[i].c_str());
+            }
+            Assert(full[i] == fast[i], "Fast path result differs from the full parser");
+        }
+        Assert(gc_fast_path_lines >= 10, "Fast path was not taken");
+    }
+}
+
+#endif
@@ -0,0 +1,105 @@
+#include "../TestFramework.h"
+
+#ifndef ESP32
+
+#    include "../Motion/MotionPipeline.h"
+
+#    include <src/GCodeTokenizer.h>
+
+#    include <chrono>
+#    include <cmath>
+#    include <cstdio>
+#    include <cstdlib>
+
+// Times the G-code parser on its own: first the tokenizer, then all of gc_execute_line()
+// in check mode, where the motion is checked but never reaches the planner.  The program
+// is read from the file named by FLUIDNC_BENCH_GCODE, or generated if that is not set.
+
+namespace Pipeline {
+    // 3D finishing passes in the styles that CAM programs write them
+    static std::vector<std::string> parserProgram() {
+        std::vector<std::string> lines;
+        char                     buf[100];
+
+        lines.push_back("G21 G90 G17 (surface finish)");
+        lines.push_back("G0 X0 Y0 Z1");
+        lines.push_back("G1 Z0 F2000");
+        for (int pass = 0; pass < 40; pass++) {
+            float y = pass * 0.25f;
+            for (int i = 0; i <= 500; i++) {
+                float x = (pass & 1) ? 50.0f - i * 0.1f : i * 0.1f;
+                float z = 0.2f * sinf(x * 0.5f) * cosf(y * 0.5f);
+                switch (i % 4) {
+                    case 0:
+                        snprintf(buf, sizeof(buf), "G1 X%.4f Y%.4f Z%.4f", x, y, z);
+                        break;
+                    case 1:
+                        snprintf(buf, sizeof(buf), "X%.3fY%.3fZ%.3f", x, y, z);
+                        break;
+                    case 2:
+                        snprintf(buf, sizeof(buf), "N%d g1 x%.3f z%.3f f%d", i, x, z, 1500 + (i % 7) * 100);
+                        break;
+                    default:
+                        snprintf(buf, sizeof(buf), "G1 X%.3f Y%.3f Z%.3f ; step %d", x, y, z, i);
+                        break;
+                }
+                lines.push_back(buf);
+            }
+        }
+        lines.push_back("G0 Z1");
+        return lines;
+    }
+
+    Test(Parser, Benchmark) {
+        Assert(MotionPipeline::init(), "Machine configuration failed to load");
+
+        const char*              filename = getenv("FLUIDNC_BENCH_GCODE");
+        std::vector<std::string> program  = filename ? MotionPipeline::readLines(filename) : parserProgram();
+        Assert(program.size() > 0, "Empty G-code program");
+
+        const int repeats = 5;
+        char      buf[Channel::maxLine];
+
+        size_t words = 0;
+        auto   start = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++) {
+            for (auto& line : program) {
+                static gc_words_t tokens;
+                strncpy(buf, line.c_str(), sizeof(buf) - 1);
+                buf[sizeof(buf) - 1] = '\0';
+                gc_tokenize(buf, tokens);
+                words += tokens.count;
+            }
+        }
+        double tokenizeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Check mode runs every error check and the kinematics, but queues nothing
+        sys.state     = State::CheckMode;
+        size_t errors = 0;
+        start         = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++) {
+            for (auto& line : program) {
+                strncpy(buf, line.c_str(), sizeof(buf) - 1);
+                buf[sizeof(buf) - 1] = '\0';
+                if (gc_execute_line(buf) != Error::Ok) {
+                    ++errors;
+                }
+            }
+        }
+        double parseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        sys.state           = State::Idle;
+        MotionPipeline::reset();
+
+        size_t lines = program.size() * repeats;
+        Debug("Parser: %u lines, %u words, %u errors", unsigned(lines), unsigned(words), unsigned(errors));
+        Debug("Parser: tokenize %.0f ns/line, gc_execute_line %.0f ns/line",
+              tokenizeSeconds * 1e9 / lines,
+              parseSeconds * 1e9 / lines);
+
+        // A given file may test error cases on purpose, so only the generated program must be clean
+        Assert(filename || errors == 0, "G-code errors in benchmark program");
+        Assert(plan_get_current_block() == nullptr, "Check mode queued motion");
+    }
+}
+
+#endif
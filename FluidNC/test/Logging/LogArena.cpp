@@ -0,0 +1,72 @@
+#include "../TestFramework.h"
+
+#ifndef ESP32
+
+#    include <src/Channel.h>
+#    include <src/Logging.h>
+
+#    include <memory>
+#    include <string>
+#    include <vector>
+
+// Messages are built in the LogStream arena.  Long messages, and messages that
+// find the arena full, move to the heap; either way the text must come out whole.
+
+namespace Logging {
+    class LineCapture : public Channel {
+        std::string _current;
+
+    public:
+        std::vector<std::string> _lines;
+
+        LineCapture() : Channel("capture") {}
+
+        size_t write(uint8_t c) override {
+            if (c == '\n') {
+                _lines.push_back(_current);
+                _current.clear();
+            } else if (c != '\r') {
+                _current += char(c);
+            }
+            return 1;
+        }
+        void flush() override {}
+    };
+
+    Test(Logging, Arena) {
+        LineCapture out;
+
+        uint32_t oversize = log_oversize;
+        log_to(out, "[TEST:", "short " << 42);
+        Assert(out._lines.back() == "[TEST:short 42]", "Short message");
+        Assert(log_oversize == oversize, "Short message left the arena");
+
+        // Fills the slot exactly, then goes one past it
+        std::string fits(LogStream::slotSize - 2 - 6, 'x');
+        log_to(out, "[TEST:", fits.c_str());
+        Assert(out._lines.back() == "[TEST:" + fits + "]", "Full slot");
+        Assert(log_oversize == oversize, "Full slot left the arena");
+
+        std::string longText(3 * LogStream::slotSize, 'y');
+        log_to(out, "[TEST:", longText.c_str() << " end");
+        Assert(out._lines.back() == "[TEST:" + longText + " end]", "Long message");
+        Assert(log_oversize == oversize + 1, "Long message was not counted");
+
+        // Streams that are open at the same time use a slot each
+        uint32_t                                full = log_arena_full;
+        std::vector<std::unique_ptr<LogStream>> open;
+        for (int i = 0; i < LogStream::nSlots + 2; i++) {
+            open.emplace_back(new LogStream(out, "nested "));
+            *open.back() << i;
+        }
+        for (auto& stream : open) {
+            stream.reset();
+        }
+        Assert(log_arena_full == full + 2, "Arena exhaustion was not counted");
+        for (int i = 0; i < LogStream::nSlots + 2; i++) {
+            Assert(out._lines[out._lines.size() - 1 - i] == "nested " + std::to_string(LogStream::nSlots + 1 - i), "Nested message");
+        }
+    }
+}
+
+#endif
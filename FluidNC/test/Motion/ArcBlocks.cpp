@@ -0,0 +1,67 @@
+#include "../TestFramework.h"
+
+#ifndef ESP32
+
+#    include "MotionPipeline.h"
+#    include "StepTraceFile.h"
+
+#    include <cmath>
+
+// With arc_blocks, each arc is one planner block and the stepper follows the arc
+// itself.  Both arcs below lie on the circle of radius 5 around X15 Y5, so every
+// step the ISR makes must stay on that circle, to within the step resolution and
+// the sagitta of one segment.
+
+namespace Pipeline {
+    static std::string arcConfig = std::string(pipelineConfig) + "arc_blocks: true\n";
+
+    Test(Pipeline, ArcBlocks) {
+        Assert(MotionPipeline::init(arcConfig.c_str()), "Machine configuration failed to load");
+        MotionPipeline::reset();
+        SimulatedStepTimer::setManual(true);
+
+        Assert(MotionPipeline::executeLineLockstep("G21 G90 G17 G0 X10 Y5 Z0", 4) == Error::Ok, "Move to the arc start failed");
+        MotionPipeline::finishLockstep();
+
+        auto    n_axis = config->_axes->_numberAxis;
+        int32_t position[MAX_N_AXIS];
+        for (int axis = 0; axis < n_axis; axis++) {
+            position[axis] = get_axis_motor_steps(axis);
+        }
+        uint32_t blocks = plan_get_block_count();
+
+        StepTraceFile trace;
+        Assert(StepTrace::start(1 << 16), "Cannot allocate the trace ring");
+        for (auto line : { "G2 X10 Y5 I5 J0 F3000", "G3 X20 Y5 Z-1 I5 J0" }) {
+            Assert(MotionPipeline::executeLineLockstep(line, 4) == Error::Ok, line);
+            trace.drain();
+        }
+        MotionPipeline::finishLockstep();
+        trace.drain();
+        Assert(StepTrace::overruns() == 0, "Trace ring overflowed");
+        StepTrace::stop();
+        SimulatedStepTimer::setManual(false);
+
+        Assert(plan_get_block_count() - blocks == 2, "Each arc should take one planner block");
+
+        float maxError = 0.0f;
+        for (auto& r : trace._records) {
+            for (int axis = 0; axis < n_axis; axis++) {
+                if (bitnum_is_true(r.step_mask, axis)) {
+                    position[axis] += bitnum_is_true(r.dir_mask, axis) ? -1 : 1;
+                }
+            }
+            float x  = position[X_AXIS] / config->_axes->_axis[X_AXIS]->_stepsPerMm;
+            float y  = position[Y_AXIS] / config->_axes->_axis[Y_AXIS]->_stepsPerMm;
+            maxError = MAX(maxError, fabsf(hypotf(x - 15.0f, y - 5.0f) - 5.0f));
+        }
+        Debug("ArcBlocks: %u steps, max radial error %.4f mm", unsigned(trace._records.size()), maxError);
+        Assert(maxError < 0.03f, "Steps strayed from the arc");
+
+        Assert(get_axis_motor_steps(X_AXIS) == 1600, "Arc did not end at the target");
+        Assert(get_axis_motor_steps(Y_AXIS) == 400, "Arc did not end at the target");
+        Assert(get_axis_motor_steps(Z_AXIS) == -400, "Helix did not end at the target");
+    }
+}
+
+#endif
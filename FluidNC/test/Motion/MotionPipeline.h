@@ -0,0 +1,166 @@
+#pragma once
+
+// Helpers for running the motion pipeline (GCode -> Planner -> Stepper) on the host.
+// The step timer is provided by X86TestSupport (SimulatedStepTimer.h), which calls
+// Stepper::pulse_func() back-to-back from its own thread while stepping is active.
+
+#ifndef ESP32
+
+#    include <src/Machine/MachineConfig.h>
+#    include <src/GCode.h>
+#    include <src/Planner.h>
+#    include <src/Stepper.h>
+#    include <src/Protocol.h>
+#    include <src/MotionControl.h>
+#    include <src/Settings.h>
+#    include <src/System.h>
+#    include <src/StringRange.h>
+
+#    include <SimulatedStepTimer.h>
+
+#    include <cstring>
+#    include <fstream>
+#    include <string>
+#    include <thread>
+#    include <vector>
+
+namespace Pipeline {
+    // A plain three-axis machine with no I/O, so nothing but the motion code is exercised.
+    static const char* pipelineConfig = "name: Pipeline\n"
+                                        "board: None\n"
+                                        "stepping:\n"
+                                        "  engine: RMT\n"
+                                        "  segments: 12\n"
+                                        "  idle_ms: 255\n"
+                                        "axes:\n"
+                                        "  x:\n"
+                                        "    steps_per_mm: 80\n"
+                                        "    max_rate_mm_per_min: 5000\n"
+                                        "    acceleration_mm_per_sec2: 500\n"
+                                        "    max_travel_mm: 1000\n"
+                                        "  y:\n"
+                                        "    steps_per_mm: 80\n"
+                                        "    max_rate_mm_per_min: 5000\n"
+                                        "    acceleration_mm_per_sec2: 500\n"
+                                        "    max_travel_mm: 1000\n"
+                                        "  z:\n"
+                                        "    steps_per_mm: 400\n"
+                                        "    max_rate_mm_per_min: 1000\n"
+                                        "    acceleration_mm_per_sec2: 100\n"
+                                        "    max_travel_mm: 100\n";
+
+    class MotionPipeline {
+    public:
+        // Loads the given machine configuration and initializes the subsystems that
+        // the motion path needs, in the same order as setup() and reset_variables().
+        static bool init(const char* yaml = pipelineConfig) {
+            static bool protocolInitialized = false;
+            if (!protocolInitialized) {
+                protocol_init();
+                settings_init();
+                protocolInitialized = true;
+            }
+            if (!Machine::MachineConfig::load(new StringRange(yaml))) {
+                return false;
+            }
+            config->_stepping->init();
+            plan_init();
+            config->_axes->init();
+            config->_kinematics->init();
+            sys.state = State::Idle;
+            for (auto s : config->_spindles) {
+                s->init();
+            }
+            Spindles::Spindle::switchSpindle(0, config->_spindles, spindle);
+            config->_coolant->init();
+            reset();
+            return true;
+        }
+
+        // Equivalent of reset_variables() in Main.cpp
+        static void reset() {
+            system_reset();
+            protocol_reset();
+            gc_init();
+            plan_reset();
+            Stepper::reset();
+            plan_sync_position();
+            gc_sync_position();
+            mc_init();
+        }
+
+        // Executes one line the way protocol_main_loop() does, including the
+        // auto-cycle-start and realtime check point that follow every line.
+        static Error executeLine(const std::string& line) {
+            char buf[Channel::maxLine];
+            strncpy(buf, line.c_str(), sizeof(buf) - 1);
+            buf[sizeof(buf) - 1] = '\0';
+
+            Error result = gc_execute_line(buf);
+            protocol_auto_cycle_start();
+            protocol_execute_realtime();
+            return result;
+        }
+
+        // Waits until every queued block has been turned into steps.  When the step
+        // thread runs the segment buffer dry, the ISR stops and posts a cycle stop,
+        // which can idle the machine just after prep has queued the last segments of
+        // the planner.  Those segments are then started here, as a cycle start would.
+        static void finish() {
+            while (true) {
+                protocol_buffer_synchronize();
+                while (SimulatedStepTimer::running()) {
+                    std::this_thread::yield();
+                }
+                if (sys.abort || (!plan_get_current_block() && !Stepper::segments_pending())) {
+                    return;
+                }
+                if (!plan_get_current_block()) {
+                    sys.state = State::Cycle;
+                    Stepper::wake_up();
+                }
+            }
+        }
+
+        // Lock-step mode, for repeatable step output.  The step timer only runs inside pump(),
+        // so the foreground and the ISR always interleave the same way.  Each line must fit in
+        // the free planner blocks kept by executeLineLockstep(), since nothing drains the planner
+        // while gc_execute_line() waits for room.
+        static const int pumpTicks = 200;
+
+        // One main loop pass followed by a fixed number of ISR ticks
+        static void pump() {
+            protocol_auto_cycle_start();
+            protocol_execute_realtime();
+            for (int i = 0; i < pumpTicks && SimulatedStepTimer::fire(); i++) {}
+        }
+
+        static Error executeLineLockstep(const std::string& line, int freeBlocks) {
+            while (plan_get_block_buffer_available() < freeBlocks) {
+                pump();
+            }
+            return executeLine(line);
+        }
+
+        static void finishLockstep() {
+            while (plan_get_current_block() || SimulatedStepTimer::running() || sys.state == State::Cycle) {
+                pump();
+            }
+        }
+
+        static std::vector<std::string> readLines(const char* filename) {
+            std::vector<std::string> lines;
+            std::ifstream            file(filename);
+            std::string              line;
+            while (std::getline(file, line)) {
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                lines.push_back(line);
+            }
+            return lines;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "../TestFramework.h"
+
+#ifndef ESP32
+
+#    include "MotionPipeline.h"
+
+#    include <chrono>
+#    include <cmath>
+#    include <cstdio>
+#    include <cstdlib>
+
+// Feeds a G-code program through gc_execute_line() -> mc_linear()/mc_arc() -> plan_buffer_line()
+// -> Stepper::prep_buffer() -> Stepper::pulse_func() and reports the throughput of each stage.
+// The program is read from the file named by FLUIDNC_BENCH_GCODE, e.g. src/tests/arcs_arrows.nc,
+// or generated if that variable is not set.
+
+namespace Pipeline {
+    // Dense short-segment surfacing passes, like a 3D finishing toolpath, followed by
+    // a batch of full circles to exercise the arc path.
+    static std::vector<std::string> syntheticProgram() {
+        std::vector<std::string> lines;
+        char                     buf[80];
+
+        lines.push_back("G21 G90 G17");
+        lines.push_back("G0 X0 Y0 Z1");
+        lines.push_back("G1 Z0 F2000");
+        for (int pass = 0; pass < 20; pass++) {
+            float y = pass * 0.5f;
+            for (int i = 0; i <= 500; i++) {
+                float x = (pass & 1) ? 50.0f - i * 0.1f : i * 0.1f;
+                float z = 0.2f * sinf(x * 0.5f) * cosf(y * 0.5f);
+                snprintf(buf, sizeof(buf), "G1 X%.3f Y%.3f Z%.3f", x, y, z);
+                lines.push_back(buf);
+            }
+        }
+        lines.push_back("G0 Z1");
+        lines.push_back("G0 X20 Y20");
+        for (int i = 0; i < 50; i++) {
+            lines.push_back("G2 X20 Y20 I5 J0 F3000");
+            lines.push_back("G3 X20 Y20 I-2.5 J0");
+        }
+        lines.push_back("G0 X0 Y0 Z1");
+        return lines;
+    }
+
+    Test(Pipeline, Benchmark) {
+        Assert(MotionPipeline::init(), "Machine configuration failed to load");
+
+        const char*              filename = getenv("FLUIDNC_BENCH_GCODE");
+        std::vector<std::string> program  = filename ? MotionPipeline::readLines(filename) : syntheticProgram();
+        Assert(program.size() > 0, "Empty G-code program");
+
+        SimulatedStepTimer::resetCounters();
+        uint32_t startBlocks = plan_get_block_count();
+        size_t   errors      = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (auto& line : program) {
+            if (MotionPipeline::executeLine(line) != Error::Ok) {
+                ++errors;
+            }
+        }
+        MotionPipeline::finish();
+        auto end = std::chrono::steady_clock::now();
+
+        double   seconds  = std::chrono::duration<double>(end - start).count();
+        uint32_t blocks   = plan_get_block_count() - startBlocks;
+        uint64_t segments = SimulatedStepTimer::periodChanges();
+        uint64_t ticks    = SimulatedStepTimer::isrCalls();
+
+        Debug("Pipeline: %u lines, %u blocks, %llu segments, %llu ISR ticks in %.3f s",
+              unsigned(program.size()),
+              unsigned(blocks),
+              (unsigned long long)segments,
+              (unsigned long long)ticks,
+              seconds);
+        Debug("Pipeline: %.0f lines/s, %.0f blocks/s, %.0f segments/s, %.0f ISR ticks/s",
+              program.size() / seconds,
+              blocks / seconds,
+              segments / seconds,
+              ticks / seconds);
+        Debug("Pipeline: simulated machine time %.3f s", SimulatedStepTimer::ticks() / double(Machine::Stepping::fStepperTimer));
+
+        Assert(errors == 0, "G-code errors in benchmark program");
+        Assert(blocks >= program.size() / 2, "Too few planner blocks were queued");
+        Assert(segments > 0 && ticks > 0, "Stepper did not run");
+        Assert(plan_get_current_block() == nullptr, "Planner did not drain");
+    }
+}
+
+#endif
@@ -0,0 +1,145 @@
+#include "../TestFramework.h"
+
+#ifndef ESP32
+
+#    include "MotionPipeline.h"
+
+#    include <src/Spindles/NullSpindle.h>
+
+// Raster lines carry one power value per pixel, and the stepper ISR sets the laser power
+// when the steps of the line cross into each pixel.  The pool that holds the pixels is
+// smaller than the job, so the lines also have to wait for the pool to drain.
+
+namespace Pipeline {
+    static std::string rasterConfig = std::string(pipelineConfig) + "raster_buffer_bytes: 128\n";
+
+    // Records every power change with the X position at which it happened
+    class PowerRecorder : public Spindles::Null {
+    public:
+        struct Change {
+            int32_t  x_steps;
+            int32_t  y_steps;
+            uint32_t dev_speed;
+        };
+        std::vector<Change> _changes;
+
+        PowerRecorder() {
+            linearSpeeds(1000, 100.0f);
+            setupSpeeds(1000);
+        }
+
+        void setSpeedfromISR(uint32_t dev_speed) override { _changes.push_back({ get_axis_motor_steps(X_AXIS), get_axis_motor_steps(Y_AXIS), dev_speed }); }
+    };
+
+    // Queues a raster line in lock-step mode, first running the stepper until the pool has
+    // room for its pixels, since mc_raster() only waits for the ISR to release them.
+    static bool rasterLockstep(float* target, plan_line_data_t* pl_data, const uint8_t* pixels, uint16_t n_pixels) {
+        while (plan_get_block_buffer_available() < 1 || !plan_raster_alloc(n_pixels)) {
+            MotionPipeline::pump();
+        }
+        bool queued = mc_raster(target, pl_data, gc_state.position, pixels, n_pixels);
+        copyAxes(gc_state.position, target);
+        return queued;
+    }
+
+    Test(Pipeline, RasterBlocks) {
+        Assert(MotionPipeline::init(rasterConfig.c_str()), "Machine configuration failed to load");
+        MotionPipeline::reset();
+        SimulatedStepTimer::setManual(true);
+
+        const int lines        = 6;
+        const int pixels       = 40;
+        const int stepsPerLine = 800;  // 10 mm at 80 steps/mm
+        const int stepsPerPix  = stepsPerLine / pixels;
+
+        PowerRecorder recorder;
+        auto          oldSpindle = spindle;
+        spindle                  = &recorder;
+
+        // Every pixel of the job gets its own power, so each change identifies its pixel
+        plan_line_data_t pl_data = {};
+        pl_data.feed_rate        = 3000;
+        pl_data.spindle          = SpindleState::Cw;
+        pl_data.spindle_speed    = 1000;
+        for (int line = 0; line < lines; line++) {
+            uint8_t power[pixels];
+            for (int i = 0; i < pixels; i++) {
+                power[i] = line * pixels + i + 1;
+            }
+            float target[MAX_N_AXIS] = { 10.0f * (line + 1), 0.0f, 0.0f };
+            Assert(rasterLockstep(target, &pl_data, power, pixels), "Raster line was not queued");
+        }
+        MotionPipeline::finishLockstep();
+        SimulatedStepTimer::setManual(false);
+        spindle = oldSpindle;
+
+        Assert(get_axis_motor_steps(X_AXIS) == lines * stepsPerLine, "Raster lines did not end at the target");
+
+        bool    fired[lines * pixels] = {};
+        int32_t firstStep[lines * pixels];
+        for (auto& change : recorder._changes) {
+            int value = (change.dev_speed * 255 + 500) / 1000;
+            Assert(value >= 1 && value <= lines * pixels, "Power does not belong to any pixel");
+            int index = value - 1;
+            int lo    = (index / pixels) * stepsPerLine + (index % pixels) * stepsPerPix;
+            Assert(change.x_steps >= lo && change.x_steps <= lo + stepsPerPix, "Pixel fired outside of its steps");
+            if (!fired[index]) {
+                fired[index]     = true;
+                firstStep[index] = change.x_steps;
+            }
+        }
+        for (int index = 0; index < lines * pixels; index++) {
+            Assert(fired[index], "Pixel was never fired");
+            if (index % pixels) {
+                int lo = (index / pixels) * stepsPerLine + (index % pixels) * stepsPerPix;
+                Assert(firstStep[index] == lo, "Pixel did not start on its first step");
+            }
+        }
+        Debug("RasterBlocks: %u power changes", unsigned(recorder._changes.size()));
+    }
+
+    // An arc block gets a stepper block per segment, in slots that the raster lines before it
+    // have used. Each of those segments must set the arc's power instead of playing pixels.
+    Test(Pipeline, RasterThenArc) {
+        std::string arcConfig = rasterConfig + "arc_blocks: true\n";
+        Assert(MotionPipeline::init(arcConfig.c_str()), "Machine configuration failed to load");
+        MotionPipeline::reset();
+        SimulatedStepTimer::setManual(true);
+
+        PowerRecorder recorder;
+        auto          oldSpindle = spindle;
+        spindle                  = &recorder;
+        Assert(MotionPipeline::executeLine("M3 S500") == Error::Ok, "Spindle did not start");
+
+        // More raster lines than stepper block slots, so that every slot has held one
+        const int        lines   = config->_stepping->_segments + 1;
+        plan_line_data_t pl_data = {};
+        pl_data.feed_rate        = 3000;
+        pl_data.spindle          = SpindleState::Cw;
+        pl_data.spindle_speed    = 1000;
+        for (int line = 0; line < lines; line++) {
+            uint8_t power[]            = { 255, 0, 255, 0 };
+            float   target[MAX_N_AXIS] = { float(line + 1), 0.0f, 0.0f };
+            Assert(mc_raster(target, &pl_data, gc_state.position, power, sizeof(power)), "Raster line was not queued");
+            copyAxes(gc_state.position, target);
+        }
+        Assert(MotionPipeline::executeLineLockstep("G17 G3 X" + std::to_string(lines - 10) + " Y0 I-5 J0 F3000", 1) == Error::Ok,
+               "Arc was not queued");
+        MotionPipeline::finishLockstep();
+        SimulatedStepTimer::setManual(false);
+        spindle = oldSpindle;
+
+        Assert(get_axis_motor_steps(X_AXIS) == (lines - 10) * 80, "Arc did not end at the target");
+        size_t arcChanges = 0;
+        for (auto& change : recorder._changes) {
+            if (change.y_steps > 0) {
+                Assert(change.dev_speed == 500, "Arc segment played a raster pixel");
+                arcChanges++;
+            }
+        }
+        Debug("RasterThenArc: %u power changes on the arc", unsigned(arcChanges));
+        Assert(arcChanges > size_t(lines), "Arc segments did not set the power");
+    }
+}
+
+#endif
@@ -0,0 +1,169 @@
+#pragma once
+
+// Host-side tools for step traces recorded by src/StepTrace.h: a compact binary file
+// format, a replay that integrates the steps into motor positions and step-rate
+// statistics, and a diff that finds the first place two traces disagree.
+//
+// File layout, little-endian:
+//   "FNST" magic, uint32 version, uint32 timer frequency, uint32 record count,
+//   then per record: uint32 ticks, uint8 step mask, uint8 dir mask.
+
+#include <src/StepTrace.h>
+#include <src/Config.h>  // MAX_N_AXIS
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace Pipeline {
+    class StepTraceFile {
+        static const uint32_t version = 1;
+
+        static void put32(FILE* f, uint32_t v) {
+            uint8_t b[4] = { uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24) };
+            fwrite(b, 1, 4, f);
+        }
+        static bool get32(FILE* f, uint32_t& v) {
+            uint8_t b[4];
+            if (fread(b, 1, 4, f) != 4) {
+                return false;
+            }
+            v = uint32_t(b[0]) | (uint32_t(b[1]) << 8) | (uint32_t(b[2]) << 16) | (uint32_t(b[3]) << 24);
+            return true;
+        }
+
+    public:
+        using Record = StepTrace::Record;
+
+        uint32_t            _frequency = 0;
+        std::vector<Record> _records;
+
+        // Moves everything the ISR has recorded so far into _records
+        void drain() {
+            Record buf[256];
+            size_t n;
+            while ((n = StepTrace::read(buf, 256)) != 0) {
+                _records.insert(_records.end(), buf, buf + n);
+            }
+        }
+
+        bool save(const char* filename) const {
+            FILE* f = fopen(filename, "wb");
+            if (!f) {
+                return false;
+            }
+            fwrite("FNST", 1, 4, f);
+            put32(f, version);
+            put32(f, _frequency);
+            put32(f, uint32_t(_records.size()));
+            for (auto& r : _records) {
+                put32(f, r.ticks);
+                fputc(r.step_mask, f);
+                fputc(r.dir_mask, f);
+            }
+            fclose(f);
+            return true;
+        }
+
+        bool load(const char* filename) {
+            FILE* f = fopen(filename, "rb");
+            if (!f) {
+                return false;
+            }
+            char     magic[4];
+            uint32_t fileVersion, count;
+            bool     ok = fread(magic, 1, 4, f) == 4 && memcmp(magic, "FNST", 4) == 0 && get32(f, fileVersion) &&
+                      fileVersion == version && get32(f, _frequency) && get32(f, count);
+            _records.clear();
+            for (uint32_t i = 0; ok && i < count; i++) {
+                Record r;
+                int    step, dir;
+                ok = get32(f, r.ticks) && (step = fgetc(f)) != EOF && (dir = fgetc(f)) != EOF;
+                if (ok) {
+                    r.step_mask = uint8_t(step);
+                    r.dir_mask  = uint8_t(dir);
+                    _records.push_back(r);
+                }
+            }
+            fclose(f);
+            return ok;
+        }
+
+        // Result of replaying a trace
+        struct Replay {
+            int32_t  position[MAX_N_AXIS]   = { 0 };  // Net steps per axis
+            uint32_t steps[MAX_N_AXIS]      = { 0 };  // Total steps per axis
+            uint32_t minInterval[MAX_N_AXIS];         // Shortest time between steps, in ticks
+            uint32_t maxJitter[MAX_N_AXIS]  = { 0 };  // Largest change between consecutive step intervals
+            uint32_t duration               = 0;      // Ticks from the first to the last step
+        };
+
+        // Integrates the trace into motor positions and per-axis step timing.  A set
+        // direction bit means the motor moves in the negative direction.
+        Replay replay() const {
+            Replay   result;
+            uint32_t lastStep[MAX_N_AXIS];
+            uint32_t lastInterval[MAX_N_AXIS] = { 0 };
+            for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+                result.minInterval[axis] = UINT32_MAX;
+            }
+            for (auto& r : _records) {
+                for (int axis = 0; axis < MAX_N_AXIS; axis++) {
+                    if (!(r.step_mask & (1 << axis))) {
+                        continue;
+                    }
+                    result.position[axis] += (r.dir_mask & (1 << axis)) ? -1 : 1;
+                    if (result.steps[axis]++) {
+                        uint32_t interval = r.ticks - lastStep[axis];
+                        if (interval < result.minInterval[axis]) {
+                            result.minInterval[axis] = interval;
+                        }
+                        if (lastInterval[axis]) {
+                            uint32_t jitter = interval > lastInterval[axis] ? interval - lastInterval[axis] : lastInterval[axis] - interval;
+                            if (jitter > result.maxJitter[axis]) {
+                                result.maxJitter[axis] = jitter;
+                            }
+                        }
+                        lastInterval[axis] = interval;
+                    }
+                    lastStep[axis] = r.ticks;
+                }
+            }
+            if (!_records.empty()) {
+                result.duration = _records.back().ticks - _records.front().ticks;
+            }
+            return result;
+        }
+
+        // Returns the index of the first record that differs from other, or -1 if the
+        // traces are identical.  With timing == false only the masks are compared, so a
+        // change in step timing that keeps the step sequence is not reported.
+        long diff(const StepTraceFile& other, bool timing = true) const {
+            size_t n = _records.size() < other._records.size() ? _records.size() : other._records.size();
+            for (size_t i = 0; i < n; i++) {
+                auto& a = _records[i];
+                auto& b = other._records[i];
+                if (a.step_mask != b.step_mask || a.dir_mask != b.dir_mask || (timing && a.ticks != b.ticks)) {
+                    return long(i);
+                }
+            }
+            return _records.size() == other._records.size() ? -1 : long(n);
+        }
+
+        // FNV-1a hash of the records, so a test can compare against a golden trace
+        // without keeping the whole trace in the tree.
+        uint32_t hash() const {
+            uint32_t h   = 2166136261u;
+            auto     mix = [&h](uint8_t b) { h = (h ^ b) * 16777619u; };
+            for (auto& r : _records) {
+                for (int shift = 0; shift < 32; shift += 8) {
+                    mix(uint8_t(r.ticks >> shift));
+                }
+                mix(r.step_mask);
+                mix(r.dir_mask);
+            }
+            return h;
+        }
+    };
+}
@@ -0,0 +1,129 @@
+#include "../TestFramework.h"
+
+#ifndef ESP32
+
+#    include "MotionPipeline.h"
+#    include "StepTraceFile.h"
+
+#    include <cstdio>
+#    include <cstdlib>
+
+// Records the step trace of a G-code program and compares it with a golden trace.
+// The pipeline runs in lock-step mode, so the trace of a given program and
+// configuration is always the same.
+//
+// The built-in program is always compared with the golden record count and hash below.
+//
+//   FLUIDNC_BENCH_GCODE         program to run (default: a short built-in program)
+//   FLUIDNC_STEP_TRACE_GOLDEN   trace file to compare against, e.g. for a custom program
+//   FLUIDNC_STEP_TRACE_OUT      where to save the new trace, e.g. to create a golden file
+//
+// A difference is reported with the first record that disagrees, which is usually
+// enough to find the planner block that changed.
+
+namespace Pipeline {
+    static std::vector<std::string> traceProgram() {
+        return {
+            "G21 G90 G17",         //
+            "G0 X5 Y5",            //
+            "G1 X10 Y7 F1500",     //
+            "G1 X12.5 Y7.1 Z-0.5", //
+            "G2 X12.5 Y7.1 I2 J0", //
+            "G3 X20 Y7.1 R3.75",   //
+            "G1 X0.1 Y0.2 Z0",     //
+            "G91 G1 X-0.1 Y-0.2",  //
+            "G90 G0 X0 Y0 Z0",     //
+        };
+    }
+
+    static std::string traceConfig = std::string(pipelineConfig) + "planner_blocks: 120\n";
+
+    // Golden trace of traceProgram() with traceConfig.  A change that is meant to
+    // alter the step output must update these; GoldenReplay prints the new values.
+    static const size_t   goldenRecords = 5744;
+    static const uint32_t goldenHash    = 0x3b9c95fe;
+
+    // Enough planner room for the chords of the arcs in traceProgram()
+    static const int freeBlocks = 100;
+
+    static StepTraceFile recordTrace(const std::vector<std::string>& program) {
+        StepTraceFile trace;
+        trace._frequency = Machine::Stepping::fStepperTimer;
+
+        MotionPipeline::reset();
+        SimulatedStepTimer::setManual(true);
+        Assert(StepTrace::start(1 << 16), "Cannot allocate the trace ring");
+        for (auto& line : program) {
+            Assert(MotionPipeline::executeLineLockstep(line, freeBlocks) == Error::Ok, line.c_str());
+            trace.drain();
+        }
+        MotionPipeline::finishLockstep();
+        trace.drain();
+        Assert(StepTrace::overruns() == 0, "Trace ring overflowed");
+        StepTrace::stop();
+        SimulatedStepTimer::setManual(false);
+        return trace;
+    }
+
+    Test(StepTrace, GoldenReplay) {
+        Assert(MotionPipeline::init(traceConfig.c_str()), "Machine configuration failed to load");
+
+        const char* filename = getenv("FLUIDNC_BENCH_GCODE");
+        auto        program  = filename ? MotionPipeline::readLines(filename) : traceProgram();
+
+        int32_t startSteps[MAX_N_AXIS];
+        for (int axis = 0; axis < config->_axes->_numberAxis; axis++) {
+            startSteps[axis] = get_axis_motor_steps(axis);
+        }
+
+        auto trace  = recordTrace(program);
+        auto replay = trace.replay();
+
+        Debug("StepTrace: %u records, %.3f s, hash %08x",
+              unsigned(trace._records.size()),
+              replay.duration / double(trace._frequency),
+              unsigned(trace.hash()));
+        for (int axis = 0; axis < config->_axes->_numberAxis; axis++) {
+            if (replay.steps[axis]) {
+                Debug("StepTrace: axis %d %u steps, max %.0f steps/s, max jitter %u ticks",
+                      axis,
+                      replay.steps[axis],
+                      trace._frequency / double(replay.minInterval[axis]),
+                      replay.maxJitter[axis]);
+            }
+        }
+
+        // The steps must add up to the machine position where the program left it
+        for (int axis = 0; axis < config->_axes->_numberAxis; axis++) {
+            Assert(startSteps[axis] + replay.position[axis] == get_axis_motor_steps(axis), "Trace does not replay to the final position");
+        }
+
+        // A second run of the same program must give the identical trace
+        auto again = recordTrace(program);
+        Assert(trace.diff(again) == -1, "Step trace is not deterministic");
+
+        const char* out = getenv("FLUIDNC_STEP_TRACE_OUT");
+        if (out) {
+            Assert(trace.save(out), "Cannot write trace file");
+        }
+
+        // The built-in program always checks against its golden trace
+        if (!filename) {
+            Assert(trace._records.size() == goldenRecords, "Step trace record count differs from the golden trace");
+            Assert(trace.hash() == goldenHash, "Step trace differs from the golden trace");
+        }
+
+        const char* golden = getenv("FLUIDNC_STEP_TRACE_GOLDEN");
+        if (golden) {
+            StepTraceFile reference;
+            Assert(reference.load(golden), "Cannot read golden trace file");
+            long where = trace.diff(reference);
+            if (where >= 0) {
+                Debug("StepTrace: first difference at record %ld", where);
+            }
+            Assert(where == -1, "Step trace differs from the golden trace");
+        }
+    }
+}
+
+#endif
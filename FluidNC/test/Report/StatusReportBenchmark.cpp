@@ -0,0 +1,147 @@
+#include "../TestFramework.h"
+
+#ifndef ESP32
+
+#    include "../Motion/MotionPipeline.h"
+
+#    include <src/Report.h>
+#    include <src/ReportBuffer.h>
+
+#    include <chrono>
+#    include <cstdio>
+#    include <iomanip>
+#    include <sstream>
+
+// Checks that ReportBuffer::fixed() writes the same digits as printf, which the
+// status report used to get from std::fixed, and the layout of the compact frame.
+// Then times whole status reports and the formatting of one coordinate, old way
+// and new.
+
+namespace Pipeline {
+    // Keeps the last line that was sent to it
+    class ReportCapture : public Channel {
+    public:
+        std::string _current;
+        std::string _last;
+        size_t      _lines = 0;
+
+        ReportCapture() : Channel("capture") {}
+
+        size_t write(uint8_t c) override {
+            if (c == '\n') {
+                _last = _current;
+                _current.clear();
+                ++_lines;
+            } else if (c != '\r') {
+                _current += char(c);
+            }
+            return 1;
+        }
+        void flush() override {}
+    };
+
+    Test(Report, FixedFormat) {
+        const float values[] = { 0.0f,    -0.0f,   1.0f,      -1.0f,     0.0625f,    2.5f,      0.125f,  -0.0001f,
+                                 123.456f, 9.9995f, 999.9999f, 1e-7f,     -1234.5678f, 0.03125f, 100.0f,  16777216.0f,
+                                 0.5f,    1.5f,    -2.5f,     3.14159f,  25.4f,      -0.0005f,  1e9f,    -7.77777f };
+        char expected[64];
+        for (float value : values) {
+            for (int decimals = 0; decimals <= 4; decimals++) {
+                ReportBuffer msg;
+                msg.fixed(value, decimals);
+                snprintf(expected, sizeof(expected), "%.*f", decimals, double(value));
+                if (strcmp(msg.c_str(), expected)) {
+                    Debug("fixed(%g, %d) gave %s, printf gave %s", double(value), decimals, msg.c_str(), expected);
+                }
+                Assert(!strcmp(msg.c_str(), expected), "fixed() differs from printf");
+            }
+        }
+
+        // Positions as they come from step counts
+        for (int32_t steps = -100000; steps <= 100000; steps += 37) {
+            float value = steps / 80.0f;
+            for (int decimals = 3; decimals <= 4; decimals++) {
+                ReportBuffer msg;
+                msg.fixed(value, decimals);
+                snprintf(expected, sizeof(expected), "%.*f", decimals, double(value));
+                Assert(!strcmp(msg.c_str(), expected), "fixed() differs from printf");
+            }
+        }
+
+        ReportBuffer msg;
+        msg.integer(-2147483648LL);
+        msg.add(',');
+        msg.integer(4294967295LL);
+        Assert(!strcmp(msg.c_str(), "-2147483648,4294967295"), "integer() is wrong");
+    }
+
+    Test(Report, CompactFrame) {
+        Assert(MotionPipeline::init(), "Machine configuration failed to load");
+
+        ReportCapture capture;
+        report_compact_status(capture);
+
+        // Earlier tests may have left the motors anywhere
+        std::string expected = "{0";
+        char        field[16];
+        for (size_t axis = 0; axis < 3; axis++) {
+            snprintf(field, sizeof(field), "%08X", unsigned(get_axis_motor_steps(axis)));
+            expected += field;
+        }
+        snprintf(field, sizeof(field), "%04X", unsigned(plan_get_block_buffer_available()));
+        expected += std::string("000000") + "000000" + field + "00000000}";
+        Debug("CompactFrame: %s", capture._last.c_str());
+        Assert(capture._last == expected, "Compact frame is wrong");
+        Assert(capture._last.size() == 51, "Compact frame has the wrong length");
+
+        ReportBuffer msg;
+        msg.hex(uint32_t(-1), 8);
+        msg.hex(0x1234, 6);
+        Assert(!strcmp(msg.c_str(), "FFFFFFFF001234"), "hex() is wrong");
+    }
+
+    Test(Report, StatusBenchmark) {
+        Assert(MotionPipeline::init(), "Machine configuration failed to load");
+
+        ReportCapture capture;
+        const int     reports = 20000;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < reports; i++) {
+            report_realtime_status(capture);
+        }
+        double reportSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Assert(capture._lines == reports, "Wrong number of reports");
+        Assert(capture._last.front() == '<' && capture._last.back() == '>', "Report is not framed by < >");
+        Assert(capture._last.find("|MPos:") != std::string::npos, "Position is missing");
+
+        // One coordinate, the way the report used to format it
+        const int values = 200000;
+        size_t    chars  = 0;
+        start            = std::chrono::steady_clock::now();
+        for (int i = 0; i < values; i++) {
+            std::ostringstream s;
+            s << std::fixed << std::setprecision(3) << (i * 0.0125f - 1000.0f);
+            chars += s.str().length();
+        }
+        double streamSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < values; i++) {
+            ReportBuffer msg;
+            msg.fixed(i * 0.0125f - 1000.0f, 3);
+            chars -= msg.length();
+        }
+        double fixedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        Assert(chars == 0, "fixed() and std::fixed lengths differ");
+
+        Debug("StatusReport: %s", capture._last.c_str());
+        Debug("StatusReport: %.0f ns/report", reportSeconds * 1e9 / reports);
+        Debug("StatusReport: coordinate via ostringstream %.0f ns, via ReportBuffer %.0f ns",
+              streamSeconds * 1e9 / values,
+              fixedSeconds * 1e9 / values);
+    }
+}
+
+#endif
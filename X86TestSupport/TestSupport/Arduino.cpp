@@ -68,6 +68,12 @@ const char* EspClass::getSdkVersion() {
 uint32_t EspClass::getFreeHeap() {
     return 0xFFFF;
 }
+uint32_t EspClass::getMinFreeHeap() {
+    return 0xFFFF;
+}
+uint32_t EspClass::getMaxAllocHeap() {
+    return 0xFFFF;
+}
 uint32_t EspClass::getFlashChipSize() {
     return 4 * 1024 * 1024;
 }
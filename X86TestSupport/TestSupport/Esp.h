@@ -23,6 +23,8 @@ struct EspClass {
     uint32_t    getCpuFreqMHz();
     const char* getSdkVersion();
     uint32_t    getFreeHeap();
+    uint32_t    getMinFreeHeap();
+    uint32_t    getMaxAllocHeap();
     uint32_t    getFlashChipSize();
 
     void restart();
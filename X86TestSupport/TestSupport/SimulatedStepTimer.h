@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+
+// Host-side stand-in for the ESP32 step timer.  The Driver/StepTimer.h interface is implemented
+// by a dedicated thread that calls the stepping callback back-to-back while the timer is started,
+// advancing a simulated tick counter by the programmed alarm period on every call.  This lets the
+// whole GCode -> Planner -> Stepper pipeline run on a PC without waiting for real time to pass.
+namespace SimulatedStepTimer {
+    // Simulated timer ticks, in units of the frequency passed to stepTimerInit()
+    uint64_t ticks();
+
+    // Number of times the stepping callback has been called
+    uint64_t isrCalls();
+
+    // Number of times the alarm period was changed, i.e. the number of step segments loaded
+    uint64_t periodChanges();
+
+    // True while the timer is started and the callback has not asked to stop
+    bool running();
+
+    // Zero the counters above
+    void resetCounters();
+
+    // In manual mode the timer thread is paused and the callback only runs when fire() is
+    // called.  This makes the interleaving of the ISR with the foreground deterministic.
+    void setManual(bool manual);
+
+    // Runs one timer tick in the calling thread if the timer is started.  Returns running().
+    bool fire();
+}
@@ -0,0 +1,83 @@
+#include "SimulatedStepTimer.h"
+
+#include "../../FluidNC/include/Driver/StepTimer.h"
+
+#include <atomic>
+#include <thread>
+
+static bool (*timer_isr_callback)(void) = nullptr;
+
+static std::atomic<bool>     timer_running(false);
+static std::atomic<bool>     timer_manual(false);
+static std::atomic<uint32_t> timer_period(10);
+static std::atomic<uint64_t> timer_ticks(0);
+static std::atomic<uint64_t> timer_calls(0);
+static std::atomic<uint64_t> timer_period_changes(0);
+
+static std::thread* timer_thread = nullptr;
+
+// One simulated "interrupt"
+static void timer_tick() {
+    timer_ticks += timer_period.load(std::memory_order_relaxed);
+    ++timer_calls;
+    if (!timer_isr_callback()) {
+        timer_running.store(false, std::memory_order_release);
+    }
+}
+
+// Free-running mode runs the ISR as fast as the host allows, so it is only throttled
+// by the segment buffer running dry, like a real controller whose prep cannot keep up.
+static void timer_loop() {
+    while (true) {
+        if (!timer_manual.load(std::memory_order_acquire) && timer_running.load(std::memory_order_acquire)) {
+            timer_tick();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void stepTimerStart() {
+    timer_period.store(10);  // Interrupt very soon to start the stepping
+    timer_running.store(true, std::memory_order_release);
+}
+
+void stepTimerSetTicks(uint32_t ticks) {
+    timer_period.store(ticks, std::memory_order_relaxed);
+    ++timer_period_changes;
+}
+
+void stepTimerStop() {
+    timer_running.store(false, std::memory_order_release);
+}
+
+void stepTimerInit(uint32_t frequency, bool (*callback)(void)) {
+    timer_running.store(false);
+    timer_isr_callback = callback;
+    if (timer_thread == nullptr) {
+        timer_thread = new std::thread(timer_loop);
+        timer_thread->detach();
+    }
+}
+
+namespace SimulatedStepTimer {
+    uint64_t ticks() { return timer_ticks.load(); }
+    uint64_t isrCalls() { return timer_calls.load(); }
+    uint64_t periodChanges() { return timer_period_changes.load(); }
+    bool     running() { return timer_running.load(); }
+
+    void setManual(bool manual) { timer_manual.store(manual, std::memory_order_release); }
+
+    bool fire() {
+        if (timer_running.load(std::memory_order_acquire)) {
+            timer_tick();
+        }
+        return timer_running.load();
+    }
+
+    void resetCounters() {
+        timer_ticks          = 0;
+        timer_calls          = 0;
+        timer_period_changes = 0;
+    }
+}
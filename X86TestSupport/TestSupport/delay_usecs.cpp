@@ -0,0 +1,31 @@
+#include "../../FluidNC/include/Driver/delay_usecs.h"
+
+#include <chrono>
+
+// Host versions of the CPU cycle counter helpers.  The "CPU" runs at 240 MHz
+// like an ESP32, with ticks derived from the host's monotonic clock.
+
+static const int32_t ticks_per_us = 240;
+
+void timing_init() {}
+
+int32_t getCpuTicks() {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    return int32_t(uint64_t(ns) * ticks_per_us / 1000);
+}
+
+void delay_us(int32_t us) {
+    spinUntil(usToEndTicks(us));
+}
+
+int32_t usToCpuTicks(int32_t us) {
+    return us * ticks_per_us;
+}
+
+int32_t usToEndTicks(int32_t us) {
+    return getCpuTicks() + usToCpuTicks(us);
+}
+
+void spinUntil(int32_t endTicks) {
+    while ((getCpuTicks() - endTicks) < 0) {}
+}
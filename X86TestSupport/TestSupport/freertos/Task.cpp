@@ -39,6 +39,25 @@ TickType_t xTaskGetTickCount(void) {
     return inst.current();
 }
 
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return nullptr;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask) {
+    return 0;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait) {
+    vTaskDelay(xTicksToWait);
+    return 0;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify) {
+    return pdTRUE;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t* pxHigherPriorityTaskWoken) {}
+
 unsigned long micros() {
     return xTaskGetTickCount() / (portTICK_PERIOD_MS / 1000);
 }
@@ -31,6 +31,15 @@ void vTaskDelayUntil(TickType_t* const pxPreviousWakeTime, const TickType_t xTim
 
 TickType_t xTaskGetTickCount(void);
 
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask);
+
+// Notifications are not delivered; a task that waits for one sleeps until its timeout
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify);
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t* pxHigherPriorityTaskWoken);
+
 #define CONFIG_FREERTOS_HZ 1000
 #define configTICK_RATE_HZ (CONFIG_FREERTOS_HZ)
 #define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)